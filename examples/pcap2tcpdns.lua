@@ -1,7 +1,7 @@
 #!/usr/bin/env dnsjit
 -- Author: Petr Špaček (ISC)
 
--- Convert PCAP with IPv[46] & UDP payloads into TCP-stream binary format as
+-- Convert PCAP with IPv[46] & UDP/TCP payloads into TCP-stream binary format as
 -- specified by RFC 1035 section "4.2.2. TCP usage". Each packet is preceded by
 -- 2-byte pre‐ambule which specifies length of the following DNS message in
 -- network byte order, immediately followed by raw bytes of the DNS message.
@@ -15,6 +15,7 @@ local bit = require("bit")
 local ffi = require("ffi")
 local input = require("dnsjit.input.pcap").new()
 local layer = require("dnsjit.filter.layer").new()
+local tcpdns = require("dnsjit.filter.tcpdns").new()
 local object = require("dnsjit.core.objects")
 local log = require("dnsjit.core.log").new("pcap2tcpdns")
 local getopt = require("dnsjit.lib.getopt").new({
@@ -51,7 +52,8 @@ else
 	log:fatal("input must be specified, use -r")
 end
 layer:producer(input)
-local produce, pctx = layer:produce()
+tcpdns:producer(layer)
+local produce, pctx = tcpdns:produce()
 
 -- set up output
 io.stdout:setvbuf("full")
@@ -60,12 +62,13 @@ local obj, obj_udp, obj_pl
 local npacketsout = 0
 local npacketsskip = 0
 local UDP_ID = object.UDP
+local TCP_ID = object.TCP
 while true do
 	obj = produce(pctx)
 	if obj == nil then break end
 
 	obj_pl = obj:cast_to(object.PAYLOAD)
-	if obj_pl ~= nil and obj_pl.len <= 65535 and obj_pl:prev().obj_type == UDP_ID then
+	if obj_pl ~= nil and obj_pl.len <= 65535 and (obj_pl:prev().obj_type == UDP_ID or obj_pl:prev().obj_type == TCP_ID) then
 		-- RFC 1035 framing has just the DNS message size as two bytes (big-endian).
 		put_uint16_be(tmpbuf, 0, obj_pl.len)
 		io.stdout:write(ffi.string(tmpbuf, 2))
@@ -40,6 +40,7 @@ local layer = require("dnsjit.filter.layer").new()
 
 input:open(pcap)
 layer:producer(input)
+layer:context(true)
 
 local query = require("dnsjit.core.object.dns").new()
 local response = require("dnsjit.core.object.dns").new()
@@ -118,13 +119,12 @@ while true do
                 done = true
                 break
             end
-            local pl = obj:cast()
-            if obj:type() == "payload" and pl.len > 0 then
+            local pkt = obj:cast()
+            if pkt.payload ~= nil and pkt.len > 0 then
                 query:reset()
                 query.obj_prev = obj
 
-                local trs = pl.obj_prev:cast()
-                if trs:type() == "tcp" then
+                if pkt.proto == 6 then
                     query.includes_dnslen = 1
                 else
                     query.includes_dnslen = 0
@@ -0,0 +1,47 @@
+#!/usr/bin/env dnsjit
+local clock = require("dnsjit.lib.clock")
+local thread = require("dnsjit.core.thread")
+
+local num = tonumber(arg[2]) or 64
+local modules = {
+    "dnsjit.core.objects",
+    "dnsjit.core.channel",
+    "dnsjit.filter.layer",
+    "dnsjit.input.mmpcap",
+    "dnsjit.output.udpcli",
+}
+
+local function worker(thr)
+    require("dnsjit.core.objects")
+    require("dnsjit.core.channel")
+    require("dnsjit.filter.layer")
+    require("dnsjit.input.mmpcap")
+    require("dnsjit.output.udpcli")
+end
+
+local function now()
+    local sec, nsec = clock.monotonic()
+    return sec + nsec / 1000000000
+end
+
+local function run(opts)
+    local start = now()
+    local workers = thread.workers(num, worker, opts)
+    if not workers then
+        error("unable to start workers")
+    end
+    for _, thr in pairs(workers) do
+        thr:stop()
+    end
+    return now() - start
+end
+
+print("threads", num)
+local t = run()
+print("plain", string.format("%.6f s", t), string.format("%.1f us/thread", t / num * 1000000))
+
+local start = now()
+local factory = thread.factory(modules)
+print("factory build", string.format("%.6f s", now() - start))
+t = run({ factory = factory })
+print("factory", string.format("%.6f s", t), string.format("%.1f us/thread", t / num * 1000000))
@@ -33,11 +33,14 @@
 -- .IR script .
 module(...,package.seeall)
 
+-- dnsjit.core.broadcast (3),
 -- dnsjit.core.channel (3),
 -- dnsjit.core.compat (3),
 -- dnsjit.core.log (3),
 -- dnsjit.core.object (3),
 -- dnsjit.core.objects (3),
+-- dnsjit.core.poller (3),
+-- dnsjit.core.pool (3),
 -- dnsjit.core.producer (3),
 -- dnsjit.core.receiver (3),
 -- dnsjit.core.thread (3),
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "core/broadcast.h"
+#include "core/assert.h"
+#include "core/object.h"
+#include "core/wait.h"
+
+#include <string.h>
+
+static core_log_t       _log      = LOG_T_INIT("core.broadcast");
+static core_broadcast_t _defaults = {
+    LOG_T_INIT_OBJ("core.broadcast"),
+    0, 0, 0, 0, 0,
+    0, 0, 0,
+    0, CORE_CHANNEL_WAIT_ADAPTIVE, 1000,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    0, 0,
+    0, 0,
+    0, 0
+};
+
+core_log_t* core_broadcast_log()
+{
+    return &_log;
+}
+
+void core_broadcast_init(core_broadcast_t* self, size_t capacity, size_t consumers)
+{
+    mlassert_self();
+    if (capacity < 4 || capacity > 0x40000000 || (capacity & (capacity - 1))) {
+        mlfatal("invalid capacity");
+    }
+    if (!consumers) {
+        mlfatal("invalid number of consumers");
+    }
+
+    *self           = _defaults;
+    self->capacity  = capacity;
+    self->mask      = capacity - 1;
+    self->consumers = consumers;
+
+    lfatal_oom(self->ring = calloc(capacity, sizeof(void*)));
+    if (posix_memalign((void**)&self->cursors, sizeof(core_broadcast_cursor_t), sizeof(core_broadcast_cursor_t) * consumers)) {
+        lfatal("out of memory");
+    }
+    memset(self->cursors, 0, sizeof(core_broadcast_cursor_t) * consumers);
+}
+
+void core_broadcast_destroy(core_broadcast_t* self)
+{
+    mlassert_self();
+
+    if (self->free_objects) {
+        for (; self->tail != self->head; self->tail++) {
+            if (self->ring[self->tail & self->mask]) {
+                core_object_free((core_object_t*)self->ring[self->tail & self->mask]);
+            }
+        }
+    }
+    free(self->ring);
+    free(self->cursors);
+}
+
+/*
+ * Move the tail up to the slowest consumer, freeing the objects that all
+ * consumers are done with if requested. Only called by the producer.
+ */
+static inline void _reclaim(core_broadcast_t* self)
+{
+    unsigned int tail = self->head;
+    size_t       i;
+
+    for (i = 0; i < self->consumers; i++) {
+        unsigned int done = ck_pr_load_uint(&self->cursors[i].done);
+
+        if (self->head - done > self->head - tail) {
+            tail = done;
+        }
+    }
+    ck_pr_fence_load();
+
+    if (self->free_objects) {
+        for (; self->tail != tail; self->tail++) {
+            if (self->ring[self->tail & self->mask]) {
+                core_object_free((core_object_t*)self->ring[self->tail & self->mask]);
+            }
+        }
+    } else {
+        self->tail = tail;
+    }
+}
+
+/*
+ * Waiting works as for core.channel, the adaptive strategy spins for a
+ * while and then sleeps on a condition until the other side signals that
+ * it has published or passed an object. The waiting side registers itself
+ * and rechecks under the lock, the other side checks for waiters after
+ * updating its position so wakeups can not be lost.
+ */
+
+/*
+ * Check if there is space for the producer or an object (or close) for the
+ * consumer, cursor is 0 for the producer.
+ */
+static inline bool _ready(core_broadcast_t* self, core_broadcast_cursor_t* cursor)
+{
+    if (ck_pr_load_int(&self->closed)) {
+        return true;
+    }
+    if (!cursor) {
+        if (self->head - self->tail >= self->capacity) {
+            _reclaim(self);
+        }
+        return self->head - self->tail < self->capacity;
+    }
+    return ck_pr_load_uint(&self->head) != cursor->seq;
+}
+
+static bool _has_space(void* ctx)
+{
+    return _ready((core_broadcast_t*)ctx, 0);
+}
+
+typedef struct _getter {
+    core_broadcast_t*        self;
+    core_broadcast_cursor_t* cursor;
+} _getter_t;
+
+static bool _has_object(void* ctx)
+{
+    return _ready(((_getter_t*)ctx)->self, ((_getter_t*)ctx)->cursor);
+}
+
+static inline void _wait(core_broadcast_t* self, core_broadcast_cursor_t* cursor, unsigned int* spins)
+{
+    _getter_t getter = { self, cursor };
+
+    if (!core_wait_spin(self->wait, self->spin, spins)) {
+        return;
+    }
+    if (cursor) {
+        core_wait_sleep(&self->_log, &self->lock, &self->not_empty, &self->get_waiters, &self->get_sleeps, _has_object, &getter);
+    } else {
+        core_wait_sleep(&self->_log, &self->lock, &self->not_full, &self->put_waiters, &self->put_sleeps, _has_space, self);
+    }
+}
+
+static inline void _waited(core_broadcast_t* self, core_broadcast_cursor_t* cursor, unsigned int* spins)
+{
+    if (*spins) {
+        core_wait_count(cursor ? &self->get_spins : &self->put_spins, *spins);
+        *spins = 0;
+    }
+}
+
+static inline bool _publish(core_broadcast_t* self, const void* obj)
+{
+    if (self->head - self->tail >= self->capacity) {
+        _reclaim(self);
+        if (self->head - self->tail >= self->capacity) {
+            return false;
+        }
+    }
+
+    self->ring[self->head & self->mask] = (void*)obj;
+    ck_pr_fence_store();
+    ck_pr_store_uint(&self->head, self->head + 1);
+    core_wait_wake(&self->_log, self->wait, &self->lock, &self->not_empty, &self->get_waiters, true);
+    return true;
+}
+
+void core_broadcast_put(core_broadcast_t* self, const void* obj)
+{
+    unsigned int spins = 0;
+    mlassert_self();
+
+    while (!_publish(self, obj)) {
+        if (ck_pr_load_int(&self->closed)) {
+            linfo("broadcast closed");
+            if (self->free_objects && obj) {
+                core_object_free((core_object_t*)obj);
+            }
+            break;
+        }
+        _wait(self, 0, &spins);
+    }
+    _waited(self, 0, &spins);
+}
+
+int core_broadcast_try_put(core_broadcast_t* self, const void* obj)
+{
+    mlassert_self();
+
+    if (!_publish(self, obj)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * The object last returned to a consumer is owned by it until it gets the
+ * next one (or releases it), so the slot is not marked as done until then.
+ */
+static inline void _done(core_broadcast_t* self, core_broadcast_cursor_t* cursor)
+{
+    if (cursor->done != cursor->seq) {
+        ck_pr_fence_release();
+        ck_pr_store_uint(&cursor->done, cursor->seq);
+        core_wait_wake(&self->_log, self->wait, &self->lock, &self->not_full, &self->put_waiters, true);
+    }
+}
+
+static inline bool _consume(core_broadcast_t* self, core_broadcast_cursor_t* cursor, void** obj)
+{
+    _done(self, cursor);
+    if (ck_pr_load_uint(&self->head) == cursor->seq) {
+        return false;
+    }
+    ck_pr_fence_load();
+
+    *obj = self->ring[cursor->seq & self->mask];
+    cursor->seq++;
+    return true;
+}
+
+void* core_broadcast_get(core_broadcast_t* self, size_t consumer)
+{
+    core_broadcast_cursor_t* cursor;
+    void*                    obj   = 0;
+    unsigned int             spins = 0;
+    mlassert_self();
+    lassert(consumer < self->consumers, "invalid consumer");
+
+    cursor = &self->cursors[consumer];
+    while (!_consume(self, cursor, &obj)) {
+        if (ck_pr_load_int(&self->closed)) {
+            _waited(self, cursor, &spins);
+            linfo("broadcast closed");
+            return 0;
+        }
+        _wait(self, cursor, &spins);
+    }
+    _waited(self, cursor, &spins);
+
+    return obj;
+}
+
+void* core_broadcast_try_get(core_broadcast_t* self, size_t consumer)
+{
+    void* obj = 0;
+    mlassert_self();
+    lassert(consumer < self->consumers, "invalid consumer");
+
+    if (!_consume(self, &self->cursors[consumer], &obj)) {
+        return 0;
+    }
+
+    return obj;
+}
+
+void core_broadcast_release(core_broadcast_t* self, size_t consumer)
+{
+    mlassert_self();
+    lassert(consumer < self->consumers, "invalid consumer");
+
+    _done(self, &self->cursors[consumer]);
+}
+
+int core_broadcast_size(core_broadcast_t* self)
+{
+    mlassert_self();
+    return ck_pr_load_uint(&self->head) - ck_pr_load_uint(&self->tail);
+}
+
+void core_broadcast_close(core_broadcast_t* self)
+{
+    mlassert_self();
+    ck_pr_store_int(&self->closed, 1);
+
+    core_wait_signal(&self->_log, &self->lock, &self->not_empty, true);
+    core_wait_signal(&self->_log, &self->lock, &self->not_full, true);
+}
+
+core_receiver_t core_broadcast_receiver()
+{
+    return (core_receiver_t)core_broadcast_put;
+}
+
+void core_broadcast_run(core_broadcast_t* self, size_t consumer, core_receiver_t recv, void* ctx)
+{
+    core_broadcast_cursor_t* cursor;
+    void*                    obj   = 0;
+    unsigned int             spins = 0;
+    mlassert_self();
+    lassert(consumer < self->consumers, "invalid consumer");
+    if (!recv) {
+        lfatal("no receiver set");
+    }
+
+    cursor = &self->cursors[consumer];
+    for (;;) {
+        while (!_consume(self, cursor, &obj)) {
+            if (ck_pr_load_int(&self->closed)) {
+                _waited(self, cursor, &spins);
+                linfo("broadcast closed");
+                return;
+            }
+            _wait(self, cursor, &spins);
+        }
+        _waited(self, cursor, &spins);
+        recv(ctx, obj);
+    }
+}
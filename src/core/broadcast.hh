@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// lua:require("dnsjit.core.log")
+// lua:require("dnsjit.core.receiver_h")
+// lua:require("dnsjit.core.channel_h")
+
+typedef struct core_broadcast_cursor {
+    unsigned int seq, done;
+    char         _pad[56];
+} core_broadcast_cursor_t;
+
+typedef struct core_broadcast {
+    core_log_t               _log;
+    void**                   ring;
+    unsigned int             capacity, mask;
+    size_t                   consumers;
+    core_broadcast_cursor_t* cursors;
+    unsigned int             head, tail;
+    int                      closed;
+    int                      free_objects;
+    core_channel_wait_t      wait;
+    unsigned int             spin;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  not_full, not_empty;
+    unsigned int    put_waiters, get_waiters;
+
+    uint64_t put_spins, put_sleeps;
+    uint64_t get_spins, get_sleeps;
+} core_broadcast_t;
+
+core_log_t* core_broadcast_log();
+
+void  core_broadcast_init(core_broadcast_t* self, size_t capacity, size_t consumers);
+void  core_broadcast_destroy(core_broadcast_t* self);
+void  core_broadcast_put(core_broadcast_t* self, const void* obj);
+int   core_broadcast_try_put(core_broadcast_t* self, const void* obj);
+void* core_broadcast_get(core_broadcast_t* self, size_t consumer);
+void* core_broadcast_try_get(core_broadcast_t* self, size_t consumer);
+void  core_broadcast_release(core_broadcast_t* self, size_t consumer);
+int   core_broadcast_size(core_broadcast_t* self);
+void  core_broadcast_close(core_broadcast_t* self);
+
+core_receiver_t core_broadcast_receiver();
+void            core_broadcast_run(core_broadcast_t* self, size_t consumer, core_receiver_t recv, void* ctx);
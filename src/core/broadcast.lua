@@ -0,0 +1,195 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.core.broadcast
+-- Send the same data to multiple threads
+--   local broadcast = require("dnsjit.core.broadcast").new(4096, 2)
+--   for n = 1, 2 do
+--       threads[n]:start(function(thr)
+--           local bc, consumer = thr:pop(2)
+--           local obj = bc:get(consumer)
+--           ...
+--       end)
+--       threads[n]:push(broadcast, n - 1)
+--   end
+--   broadcast.free_objects = 1
+--   copy:receiver(broadcast)
+--   ...
+--   broadcast:close()
+--
+-- A broadcast is a single producer, multiple consumer ring buffer where
+-- every consumer gets every object, each consumer has its own read cursor
+-- and the producer only reuses a slot after all consumers have passed it.
+-- This gives fan-out of the same objects to multiple threads without
+-- copying them once per thread or using one channel per thread.
+-- .LP
+-- Consumers are identified by a number starting at 0 and each consumer
+-- must only be used by one thread.
+-- An object returned to a consumer can be used until the consumer gets
+-- the next object or releases it.
+-- .LP
+-- If
+-- .I free_objects
+-- is set, the objects are freed with
+-- .IR core_object_free ()
+-- once all consumers are done with them, the producer should then put
+-- copies of the objects (see
+-- .BR dnsjit.filter.copy (3)).
+-- .SS Attributes
+-- .TP
+-- int closed
+-- Is 1 if the broadcast has been closed.
+-- .TP
+-- int free_objects
+-- If 1, free objects once all consumers are done with them.
+-- .TP
+-- wait
+-- The wait strategy used when the ring buffer is full (for the producer)
+-- or empty (for a consumer), the same as for
+-- .BR dnsjit.core.channel (3):
+-- ADAPTIVE (default) spins and then sleeps until woken, YIELD yields the
+-- CPU and SPIN busy-waits.
+-- .TP
+-- spin
+-- Number of spins before sleeping when using the ADAPTIVE wait strategy,
+-- default 1000.
+-- .TP
+-- put_spins, put_sleeps
+-- Number of spins (or yields) and number of sleeps the producer has done
+-- waiting for space in the ring buffer.
+-- .TP
+-- get_spins, get_sleeps
+-- Number of spins (or yields) and number of sleeps consumers have done
+-- waiting for objects.
+module(...,package.seeall)
+
+require("dnsjit.core.broadcast_h")
+local ffi = require("ffi")
+local C = ffi.C
+
+local t_name = "core_broadcast_t"
+local core_broadcast_t
+local Broadcast = {
+    ADAPTIVE = "CORE_CHANNEL_WAIT_ADAPTIVE",
+    YIELD = "CORE_CHANNEL_WAIT_YIELD",
+    SPIN = "CORE_CHANNEL_WAIT_SPIN",
+}
+
+-- Create a new Broadcast, use the optional
+-- .I capacity
+-- to specify the capacity of the ring buffer and
+-- .I consumers
+-- for the number of consumers.
+-- Capacity must be a power-of-two greater than or equal to 4.
+-- Default capacity is 2048 and default number of consumers is 2.
+function Broadcast.new(capacity, consumers)
+    if capacity == nil then
+        capacity = 2048
+    end
+    if consumers == nil then
+        consumers = 2
+    end
+    local self = core_broadcast_t()
+    C.core_broadcast_init(self, capacity, consumers)
+    ffi.gc(self, C.core_broadcast_destroy)
+    return self
+end
+
+-- Return the Log object to control logging of this instance or module.
+function Broadcast:log()
+    if self == nil then
+        return C.core_broadcast_log()
+    end
+    return self._log
+end
+
+-- Return information to use when sharing this object between threads.
+function Broadcast:share()
+    return ffi.cast("void*", self), t_name.."*", "dnsjit.core.broadcast"
+end
+
+-- Put an object into the broadcast, if the ring buffer is full then it will
+-- stall and wait until all consumers have passed the oldest object.
+-- If the broadcast is closed while waiting the object is dropped (and freed
+-- if
+-- .I free_objects
+-- is set).
+-- Object may be nil.
+function Broadcast:put(obj)
+    C.core_broadcast_put(self, obj)
+end
+
+-- Try and put an object into the broadcast.
+-- Returns 0 on success.
+function Broadcast:try_put(obj)
+    return C.core_broadcast_try_put(self, obj)
+end
+
+-- Get the next object for
+-- .IR consumer ,
+-- if there are none it will wait until an object is available.
+-- Returns nil if the broadcast is closed or if a nil object was explicitly
+-- put into it.
+function Broadcast:get(consumer)
+    return C.core_broadcast_get(self, consumer)
+end
+
+-- Try and get the next object for
+-- .IR consumer .
+-- Returns nil if there was no objects to get.
+function Broadcast:try_get(consumer)
+    return C.core_broadcast_try_get(self, consumer)
+end
+
+-- Release the object last returned to
+-- .I consumer
+-- without getting the next one.
+function Broadcast:release(consumer)
+    C.core_broadcast_release(self, consumer)
+end
+
+-- Return number of objects not yet reclaimed by the producer.
+function Broadcast:size()
+    return C.core_broadcast_size(self)
+end
+
+-- Close the broadcast, wakes up both producer and consumers.
+function Broadcast:close()
+    C.core_broadcast_close(self)
+end
+
+-- Return the C functions and context for receiving objects.
+function Broadcast:receive()
+    return C.core_broadcast_receiver(), self
+end
+
+-- Retrieve all objects for
+-- .I consumer
+-- and send them to the receiver
+-- .IR o .
+function Broadcast:run(consumer, o)
+    local recv, ctx = o:receive()
+    C.core_broadcast_run(self, consumer, recv, ctx)
+end
+
+core_broadcast_t = ffi.metatype(t_name, { __index = Broadcast })
+
+-- dnsjit.core.channel (3),
+-- dnsjit.core.thread (3),
+-- dnsjit.filter.copy (3)
+return Broadcast
@@ -22,14 +22,37 @@
 
 #include "core/channel.h"
 #include "core/assert.h"
+#include "core/wait.h"
 
-#include <sched.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#if defined(HAVE_NUMA_H) && defined(HAVE_LIBNUMA)
+#include <numa.h>
+#define USE_NUMA 1
+#endif
 
 static core_log_t     _log      = LOG_T_INIT("core.channel");
 static core_channel_t _defaults = {
     LOG_T_INIT_OBJ("core.channel"),
-    0, { 0 }, 0, 0,
-    0, 0
+    0, { 0 }, 0, 0, CORE_CHANNEL_MODE_SPSC,
+    CORE_CHANNEL_WAIT_ADAPTIVE, 1000,
+    CORE_CHANNEL_OVERLOAD_BLOCK, 0, 0,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    0, 0,
+    0, 0,
+    0, 0,
+    0,
+    0, 0,
+    0, 0,
+    0, 0, { 0 },
+    -1, -1, 0,
+    -1,
+    0, 0, 0
 };
 
 core_log_t* core_channel_log()
@@ -61,20 +84,458 @@ void core_channel_init(core_channel_t* self, size_t capacity)
     ck_ring_init(&self->ring, capacity);
 }
 
+void core_channel_init_numa(core_channel_t* self, size_t capacity, int node)
+{
+    mlassert_self();
+
+#ifdef USE_NUMA
+    if (node < 0 || numa_available() < 0) {
+        core_channel_init(self, capacity);
+        return;
+    }
+    if (capacity < 4 || !_is_pow2(capacity)) {
+        mlfatal("invalid capacity");
+    }
+
+    *self           = _defaults;
+    self->capacity  = capacity;
+    self->numa_node = node;
+
+    lfatal_oom(self->ring_buf = numa_alloc_onnode(sizeof(ck_ring_buffer_t) * capacity, node));
+    ck_ring_init(&self->ring, capacity);
+#else
+    core_channel_init(self, capacity);
+    if (node > -1) {
+        lwarning("built without NUMA support, not allocating on node %d", node);
+    }
+#endif
+}
+
 void core_channel_destroy(core_channel_t* self)
 {
     mlassert_self();
+#ifdef USE_NUMA
+    if (self->numa_node > -1) {
+        numa_free(self->ring_buf, sizeof(ck_ring_buffer_t) * self->capacity);
+    } else {
+        free(self->ring_buf);
+    }
+#else
     free(self->ring_buf);
+#endif
+    if (self->notify_wfd > -1 && self->notify_wfd != self->notify_fd) {
+        close(self->notify_wfd);
+    }
+    if (self->notify_fd > -1) {
+        close(self->notify_fd);
+    }
+}
+
+/*
+ * ck_ring_*_mpsc() only exists in newer versions of ck, it is the same as
+ * using the multi producer enqueue together with the single consumer dequeue.
+ */
+
+static inline bool _enqueue(core_channel_t* self, const void* obj)
+{
+    switch (self->mode) {
+    case CORE_CHANNEL_MODE_MPSC:
+    case CORE_CHANNEL_MODE_MPMC:
+        return ck_ring_enqueue_mpmc(&self->ring, self->ring_buf, obj);
+    case CORE_CHANNEL_MODE_SPMC:
+        return ck_ring_enqueue_spmc(&self->ring, self->ring_buf, obj);
+    default:
+        break;
+    }
+    return ck_ring_enqueue_spsc(&self->ring, self->ring_buf, obj);
+}
+
+/*
+ * Dropping the oldest object means that the producer also consumes from the
+ * ring so then the consumer side always needs to be multi consumer safe.
+ * The consumer uses the policy fixed by the first put, which is done before
+ * the object is enqueued, so it can not switch while dequeuing.
+ */
+static inline bool _multi_consumer(core_channel_t* self)
+{
+    return self->mode == CORE_CHANNEL_MODE_SPMC
+           || self->mode == CORE_CHANNEL_MODE_MPMC
+           || ck_pr_load_int(&self->overload_fixed) == CORE_CHANNEL_OVERLOAD_DROP_OLDEST + 1;
+}
+
+/*
+ * Fix the overload policy on the first put, it can not be changed after.
+ */
+static inline void _fix_overload(core_channel_t* self)
+{
+    int fixed = ck_pr_load_int(&self->overload_fixed);
+
+    if (!fixed) {
+        if (ck_pr_cas_int_value(&self->overload_fixed, 0, self->overload + 1, &fixed)) {
+            return;
+        }
+    }
+    if (fixed != (int)self->overload + 1) {
+        lfatal("overload policy changed after the channel was used");
+    }
+}
+
+static inline bool _dequeue(core_channel_t* self, void** obj)
+{
+    if (_multi_consumer(self)) {
+        return ck_ring_dequeue_mpmc(&self->ring, self->ring_buf, obj);
+    }
+    return ck_ring_dequeue_spsc(&self->ring, self->ring_buf, obj);
+}
+
+/*
+ * Batched versions of the above, these reserve room for (or claim) as many
+ * entries as possible with one update of the ring's head/tail so that the
+ * synchronization cost is paid once per batch instead of once per object.
+ *
+ * They follow the same protocol as ck_ring's single and multi producer/
+ * consumer functions and must therefore be kept in sync with ck_ring.h.
+ */
+
+static inline size_t _enqueue_many(core_channel_t* self, void* const* objs, size_t num)
+{
+    ck_ring_t*        ring   = &self->ring;
+    ck_ring_buffer_t* buffer = self->ring_buf;
+    const unsigned    mask   = ring->mask;
+    unsigned int      consumer, producer, n, i;
+
+    if (!num) {
+        return 0;
+    }
+
+    switch (self->mode) {
+    case CORE_CHANNEL_MODE_MPSC:
+    case CORE_CHANNEL_MODE_MPMC:
+        producer = ck_pr_load_uint(&ring->p_head);
+        for (;;) {
+            ck_pr_fence_load();
+            consumer = ck_pr_load_uint(&ring->c_head);
+            n        = mask - (producer - consumer);
+
+            if (n) {
+                if (n > num) {
+                    n = num;
+                }
+                if (ck_pr_cas_uint_value(&ring->p_head, producer, producer + n, &producer)) {
+                    break;
+                }
+            } else {
+                unsigned int new_producer;
+
+                ck_pr_fence_load();
+                new_producer = ck_pr_load_uint(&ring->p_head);
+                if (producer == new_producer) {
+                    return 0;
+                }
+                producer = new_producer;
+            }
+        }
+
+        for (i = 0; i < n; i++) {
+            buffer[(producer + i) & mask].value = objs[i];
+        }
+        ck_pr_fence_store();
+
+        /* wait for producers that reserved before us to publish */
+        while (ck_pr_load_uint(&ring->p_tail) != producer) {
+            ck_pr_stall();
+        }
+        ck_pr_store_uint(&ring->p_tail, producer + n);
+        return n;
+
+    default:
+        break;
+    }
+
+    consumer = ck_pr_load_uint(&ring->c_head);
+    producer = ring->p_tail;
+    n        = mask - (producer - consumer);
+    if (!n) {
+        return 0;
+    }
+    if (n > num) {
+        n = num;
+    }
+
+    for (i = 0; i < n; i++) {
+        buffer[(producer + i) & mask].value = objs[i];
+    }
+    ck_pr_fence_store();
+    ck_pr_store_uint(&ring->p_tail, producer + n);
+    return n;
+}
+
+static inline size_t _dequeue_many(core_channel_t* self, void** objs, size_t num)
+{
+    ck_ring_t*        ring   = &self->ring;
+    ck_ring_buffer_t* buffer = self->ring_buf;
+    const unsigned    mask   = ring->mask;
+    unsigned int      consumer, producer, n, i;
+
+    if (!num) {
+        return 0;
+    }
+
+    if (_multi_consumer(self)) {
+        consumer = ck_pr_load_uint(&ring->c_head);
+        do {
+            ck_pr_fence_load();
+            producer = ck_pr_load_uint(&ring->p_tail);
+            n        = producer - consumer;
+            if (!n) {
+                return 0;
+            }
+            if (n > num) {
+                n = num;
+            }
+
+            ck_pr_fence_load();
+            for (i = 0; i < n; i++) {
+                objs[i] = buffer[(consumer + i) & mask].value;
+            }
+            ck_pr_fence_store();
+        } while (!ck_pr_cas_uint_value(&ring->c_head, consumer, consumer + n, &consumer));
+        return n;
+    }
+
+    consumer = ring->c_head;
+    producer = ck_pr_load_uint(&ring->p_tail);
+    n        = producer - consumer;
+    if (!n) {
+        return 0;
+    }
+    if (n > num) {
+        n = num;
+    }
+
+    ck_pr_fence_load();
+    for (i = 0; i < n; i++) {
+        objs[i] = buffer[(consumer + i) & mask].value;
+    }
+    ck_pr_fence_store();
+    ck_pr_store_uint(&ring->c_head, consumer + n);
+    return n;
+}
+
+/*
+ * Waiting for the other side of the channel.
+ *
+ * The adaptive strategy spins for a while and then sleeps on a condition
+ * until the other side signals that it has put/got something. The waiting
+ * side registers itself and rechecks the ring under the lock, the other
+ * side checks for waiters after updating the ring so wakeups can not be
+ * lost and there is no locking when no one is sleeping, see core/wait.h.
+ */
+
+static inline uint64_t _load(uint64_t* counter)
+{
+#ifdef CK_F_PR_LOAD_64
+    return ck_pr_load_64(counter);
+#else
+    return *counter;
+#endif
+}
+
+static inline bool _is_full(core_channel_t* self)
+{
+    return ck_ring_size(&self->ring) >= self->capacity - 1;
+}
+
+static inline bool _is_empty(core_channel_t* self)
+{
+    return !ck_ring_size(&self->ring);
+}
+
+static bool _has_space(void* ctx)
+{
+    core_channel_t* self = (core_channel_t*)ctx;
+    return !_is_full(self) || ck_pr_load_int(&self->closed);
+}
+
+static bool _has_objects(void* ctx)
+{
+    core_channel_t* self = (core_channel_t*)ctx;
+    return !_is_empty(self) || ck_pr_load_int(&self->closed);
+}
+
+typedef struct _waiter {
+    unsigned int    spins;
+    bool            waited;
+    struct timespec start;
+} _waiter_t;
+#define _WAITER_INIT { 0, false, { 0, 0 } }
+
+static inline void _wait(core_channel_t* self, _waiter_t* waiter, bool put)
+{
+    if (!waiter->waited) {
+        waiter->waited = true;
+        clock_gettime(CLOCK_MONOTONIC, &waiter->start);
+    }
+
+    if (!core_wait_spin(self->wait, self->spin, &waiter->spins)) {
+        return;
+    }
+    if (put) {
+        core_wait_sleep(&self->_log, &self->lock, &self->not_full, &self->put_waiters, &self->put_sleeps, _has_space, self);
+    } else {
+        core_wait_sleep(&self->_log, &self->lock, &self->not_empty, &self->get_waiters, &self->get_sleeps, _has_objects, self);
+    }
+}
+
+/*
+ * Account for the time spent waiting, if there was any.
+ */
+static inline void _waited(core_channel_t* self, _waiter_t* waiter, bool put)
+{
+    struct timespec now;
+    uint64_t        ns;
+
+    if (!waiter->waited) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ns = (uint64_t)(now.tv_sec - waiter->start.tv_sec) * 1000000000ULL + now.tv_nsec - waiter->start.tv_nsec;
+
+    if (put) {
+        core_wait_count(&self->put_stalls, 1);
+        core_wait_count(&self->put_stall_time, ns);
+        core_wait_count(&self->put_spins, waiter->spins);
+    } else {
+        core_wait_count(&self->get_idles, 1);
+        core_wait_count(&self->get_idle_time, ns);
+        core_wait_count(&self->get_spins, waiter->spins);
+    }
+    waiter->spins  = 0;
+    waiter->waited = false;
+}
+
+static inline void _notify(core_channel_t* self)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    uint64_t val = 1;
+#else
+    char val = 1;
+#endif
+
+    if (write(self->notify_wfd, &val, sizeof(val)) < 0 && errno != EAGAIN) {
+        lcritical("notify write() error: %s", core_log_errstr(errno));
+    }
+}
+
+static inline void _wake_consumers(core_channel_t* self, bool all)
+{
+    core_wait_wake(&self->_log, self->wait, &self->lock, &self->not_empty, &self->get_waiters, all);
+
+    /*
+     * Only notify if the consumer has armed the notification, this limits
+     * the writes to one per poll of the consumer.
+     */
+    if (self->notify_wfd > -1) {
+        ck_pr_fence_memory();
+        if (ck_pr_load_int(&self->notify_armed) && ck_pr_fas_int(&self->notify_armed, 0)) {
+            _notify(self);
+        }
+    }
+}
+
+static inline void _wake_producers(core_channel_t* self, bool all)
+{
+    core_wait_wake(&self->_log, self->wait, &self->lock, &self->not_full, &self->put_waiters, all);
+}
+
+/*
+ * Record the occupancy of the channel after a put, with a single producer
+ * there is only one writer so no atomic operations are needed.
+ */
+static inline void _sample(core_channel_t* self)
+{
+    unsigned int size, high;
+    uint64_t*    bucket;
+
+    if (!self->track_occupancy) {
+        return;
+    }
+
+    size   = ck_ring_size(&self->ring);
+    bucket = &self->occupancy[size * (sizeof(self->occupancy) / sizeof(self->occupancy[0])) / self->capacity];
+    high   = ck_pr_load_uint(&self->high_water);
+
+    switch (self->mode) {
+    case CORE_CHANNEL_MODE_MPSC:
+    case CORE_CHANNEL_MODE_MPMC:
+        core_wait_count(bucket, 1);
+        while (size > high && !ck_pr_cas_uint_value(&self->high_water, high, size, &high))
+            ;
+        return;
+    default:
+        break;
+    }
+
+#ifdef CK_F_PR_STORE_64
+    ck_pr_store_64(bucket, *bucket + 1);
+#else
+    (*bucket)++;
+#endif
+    if (size > high) {
+        ck_pr_store_uint(&self->high_water, size);
+    }
+}
+
+static inline void _drop(core_channel_t* self, const void* obj)
+{
+    core_wait_count(&self->dropped, 1);
+    if (self->free_dropped && obj) {
+        core_object_free((core_object_t*)obj);
+    }
+}
+
+/*
+ * Handle a full channel according to the overload policy, returns false if
+ * the producer should give up on the object(s) it is putting.
+ */
+static inline bool _overload(core_channel_t* self, _waiter_t* waiter, size_t num)
+{
+    void* obj;
+
+    switch (self->overload) {
+    case CORE_CHANNEL_OVERLOAD_DROP_NEWEST:
+        return false;
+    case CORE_CHANNEL_OVERLOAD_DROP_OLDEST:
+        while (num-- && _dequeue(self, &obj)) {
+            _drop(self, obj);
+        }
+        break;
+    default:
+        _wait(self, waiter, true);
+        break;
+    }
+    return true;
 }
 
 void core_channel_put(core_channel_t* self, const void* obj)
 {
+    _waiter_t waiter = _WAITER_INIT;
     mlassert_self();
     lassert(self->ring_buf, "ring_buf is nil");
 
-    while (!ck_ring_enqueue_spsc(&self->ring, self->ring_buf, (void*)obj)) {
-        sched_yield();
+    _fix_overload(self);
+
+    while (!_enqueue(self, obj)) {
+        if (ck_pr_load_int(&self->closed) || !_overload(self, &waiter, 1)) {
+            _drop(self, obj);
+            _waited(self, &waiter, true);
+            return;
+        }
     }
+    _sample(self);
+    _wake_consumers(self, false);
+
+    _waited(self, &waiter, true);
 }
 
 int core_channel_try_put(core_channel_t* self, const void* obj)
@@ -82,27 +543,35 @@ int core_channel_try_put(core_channel_t* self, const void* obj)
     mlassert_self();
     lassert(self->ring_buf, "ring_buf is nil");
 
-    if (!ck_ring_enqueue_spsc(&self->ring, self->ring_buf, (void*)obj)) {
+    _fix_overload(self);
+
+    if (!_enqueue(self, obj)) {
         return -1;
     }
+    _sample(self);
+    _wake_consumers(self, false);
 
     return 0;
 }
 
 void* core_channel_get(core_channel_t* self)
 {
-    void* obj = 0;
+    void*     obj    = 0;
+    _waiter_t waiter = _WAITER_INIT;
     mlassert_self();
     lassert(self->ring_buf, "ring_buf is nil");
 
-    while (!ck_ring_dequeue_spsc(&self->ring, self->ring_buf, &obj)) {
-        sched_yield();
+    while (!_dequeue(self, &obj)) {
+        _wait(self, &waiter, false);
         if (ck_pr_load_int(&self->closed)) {
             linfo("channel closed");
+            _waited(self, &waiter, false);
             return 0;
         }
     }
+    _wake_producers(self, false);
 
+    _waited(self, &waiter, false);
     return obj;
 }
 
@@ -112,13 +581,100 @@ void* core_channel_try_get(core_channel_t* self)
     mlassert_self();
     lassert(self->ring_buf, "ring_buf is nil");
 
-    if (!ck_ring_dequeue_spsc(&self->ring, self->ring_buf, &obj)) {
+    if (!_dequeue(self, &obj)) {
         return 0;
     }
+    _wake_producers(self, false);
 
     return obj;
 }
 
+void core_channel_put_many(core_channel_t* self, void* const* objs, size_t num)
+{
+    size_t    n;
+    _waiter_t waiter = _WAITER_INIT;
+    mlassert_self();
+    lassert(self->ring_buf, "ring_buf is nil");
+    lassert(objs || !num, "objs is nil");
+
+    _fix_overload(self);
+
+    while (num) {
+        if (!(n = _enqueue_many(self, objs, num))) {
+            if (ck_pr_load_int(&self->closed) || !_overload(self, &waiter, num)) {
+                while (num--) {
+                    _drop(self, *objs++);
+                }
+                break;
+            }
+            continue;
+        }
+        _sample(self);
+        _wake_consumers(self, true);
+        objs += n;
+        num -= n;
+    }
+
+    _waited(self, &waiter, true);
+}
+
+size_t core_channel_try_put_many(core_channel_t* self, void* const* objs, size_t num)
+{
+    size_t n;
+    mlassert_self();
+    lassert(self->ring_buf, "ring_buf is nil");
+    lassert(objs || !num, "objs is nil");
+
+    _fix_overload(self);
+
+    if ((n = _enqueue_many(self, objs, num))) {
+        _sample(self);
+        _wake_consumers(self, true);
+    }
+
+    return n;
+}
+
+size_t core_channel_get_many(core_channel_t* self, void** objs, size_t num)
+{
+    size_t    n;
+    _waiter_t waiter = _WAITER_INIT;
+    mlassert_self();
+    lassert(self->ring_buf, "ring_buf is nil");
+    lassert(objs || !num, "objs is nil");
+
+    if (!num) {
+        return 0;
+    }
+
+    while (!(n = _dequeue_many(self, objs, num))) {
+        _wait(self, &waiter, false);
+        if (ck_pr_load_int(&self->closed)) {
+            linfo("channel closed");
+            _waited(self, &waiter, false);
+            return 0;
+        }
+    }
+    _wake_producers(self, true);
+
+    _waited(self, &waiter, false);
+    return n;
+}
+
+size_t core_channel_try_get_many(core_channel_t* self, void** objs, size_t num)
+{
+    size_t n;
+    mlassert_self();
+    lassert(self->ring_buf, "ring_buf is nil");
+    lassert(objs || !num, "objs is nil");
+
+    if ((n = _dequeue_many(self, objs, num))) {
+        _wake_producers(self, true);
+    }
+
+    return n;
+}
+
 int core_channel_size(core_channel_t* self)
 {
     mlassert_self();
@@ -140,6 +696,101 @@ void core_channel_close(core_channel_t* self)
 {
     mlassert_self();
     ck_pr_store_int(&self->closed, 1);
+
+    core_wait_signal(&self->_log, &self->lock, &self->not_empty, true);
+    core_wait_signal(&self->_log, &self->lock, &self->not_full, true);
+
+    if (self->notify_wfd > -1) {
+        _notify(self);
+    }
+}
+
+void core_channel_stats(core_channel_t* self, core_channel_stats_t* stats)
+{
+    size_t i;
+    mlassert_self();
+    lassert(stats, "stats is nil");
+
+    stats->capacity   = self->capacity;
+    stats->size       = ck_ring_size(&self->ring);
+    stats->high_water = ck_pr_load_uint(&self->high_water);
+    for (i = 0; i < sizeof(self->occupancy) / sizeof(self->occupancy[0]); i++) {
+        stats->occupancy[i] = _load(&self->occupancy[i]);
+    }
+    stats->put_stalls     = _load(&self->put_stalls);
+    stats->put_stall_time = _load(&self->put_stall_time);
+    stats->put_spins      = _load(&self->put_spins);
+    stats->put_sleeps     = _load(&self->put_sleeps);
+    stats->get_idles      = _load(&self->get_idles);
+    stats->get_idle_time  = _load(&self->get_idle_time);
+    stats->get_spins      = _load(&self->get_spins);
+    stats->get_sleeps     = _load(&self->get_sleeps);
+    stats->dropped        = _load(&self->dropped);
+}
+
+int core_channel_notify(core_channel_t* self)
+{
+    mlassert_self();
+
+    if (self->notify_fd > -1) {
+        return self->notify_fd;
+    }
+
+#ifdef HAVE_SYS_EVENTFD_H
+    if ((self->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        lcritical("eventfd() error: %s", core_log_errstr(errno));
+        self->notify_fd = -1;
+        return -1;
+    }
+    self->notify_wfd = self->notify_fd;
+#else
+    {
+        int fds[2], i;
+
+        if (pipe(fds)) {
+            lcritical("pipe() error: %s", core_log_errstr(errno));
+            return -1;
+        }
+        for (i = 0; i < 2; i++) {
+            int flags = fcntl(fds[i], F_GETFL);
+            if (flags == -1 || fcntl(fds[i], F_SETFL, flags | O_NONBLOCK) || fcntl(fds[i], F_SETFD, FD_CLOEXEC)) {
+                lcritical("fcntl() error: %s", core_log_errstr(errno));
+                close(fds[0]);
+                close(fds[1]);
+                return -1;
+            }
+        }
+        self->notify_fd  = fds[0];
+        self->notify_wfd = fds[1];
+    }
+#endif
+
+    return self->notify_fd;
+}
+
+bool core_channel_notify_arm(core_channel_t* self)
+{
+    mlassert_self();
+    lassert(self->notify_fd > -1, "notify not enabled");
+
+    ck_pr_store_int(&self->notify_armed, 1);
+    ck_pr_fence_memory();
+
+    return !_is_empty(self) || ck_pr_load_int(&self->closed);
+}
+
+void core_channel_notify_clear(core_channel_t* self)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+    uint64_t val;
+#else
+    char val[64];
+#endif
+    mlassert_self();
+    lassert(self->notify_fd > -1, "notify not enabled");
+
+    while (read(self->notify_fd, &val, sizeof(val)) > 0)
+        ;
 }
 
 core_receiver_t core_channel_receiver()
@@ -147,9 +798,15 @@ core_receiver_t core_channel_receiver()
     return (core_receiver_t)core_channel_put;
 }
 
+core_receiver_batch_t core_channel_receiver_batch()
+{
+    return (core_receiver_batch_t)core_channel_put_many;
+}
+
 void core_channel_run(core_channel_t* self)
 {
-    void* obj = 0;
+    void*     obj    = 0;
+    _waiter_t waiter = _WAITER_INIT;
     mlassert_self();
     lassert(self->ring_buf, "ring_buf is nil");
     if (!self->recv) {
@@ -157,13 +814,57 @@ void core_channel_run(core_channel_t* self)
     }
 
     for (;;) {
-        while (!ck_ring_dequeue_spsc(&self->ring, self->ring_buf, &obj)) {
-            sched_yield();
+        while (!_dequeue(self, &obj)) {
+            _wait(self, &waiter, false);
             if (ck_pr_load_int(&self->closed)) {
                 linfo("channel closed");
+                _waited(self, &waiter, false);
                 return;
             }
         }
+        _wake_producers(self, false);
+        _waited(self, &waiter, false);
         self->recv(self->ctx, obj);
     }
 }
+
+void core_channel_run_many(core_channel_t* self, size_t num)
+{
+    void**    objs;
+    size_t    n, i;
+    _waiter_t waiter = _WAITER_INIT;
+    mlassert_self();
+    lassert(self->ring_buf, "ring_buf is nil");
+    if (!self->recv) {
+        lfatal("no receiver set");
+    }
+    if (num < 2) {
+        core_channel_run(self);
+        return;
+    }
+    if (num > self->capacity) {
+        num = self->capacity;
+    }
+
+    lfatal_oom(objs = malloc(sizeof(void*) * num));
+    for (;;) {
+        while (!(n = _dequeue_many(self, objs, num))) {
+            _wait(self, &waiter, false);
+            if (ck_pr_load_int(&self->closed)) {
+                linfo("channel closed");
+                _waited(self, &waiter, false);
+                free(objs);
+                return;
+            }
+        }
+        _wake_producers(self, true);
+        _waited(self, &waiter, false);
+        if (self->recv_batch) {
+            self->recv_batch(self->ctx, (const core_object_t**)objs, n);
+            continue;
+        }
+        for (i = 0; i < n; i++) {
+            self->recv(self->ctx, objs[i]);
+        }
+    }
+}
@@ -34,6 +34,7 @@
 
 #include <ck_ring.h>
 #include <ck_pr.h>
+#include <pthread.h>
 #include <stdbool.h>
 
 #include <dnsjit/core/channel.hh>
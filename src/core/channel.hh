@@ -22,20 +22,73 @@
 // lua:require("dnsjit.core.log")
 // lua:require("dnsjit.core.receiver_h")
 
+typedef enum core_channel_mode {
+    CORE_CHANNEL_MODE_SPSC = 0,
+    CORE_CHANNEL_MODE_MPSC = 1,
+    CORE_CHANNEL_MODE_SPMC = 2,
+    CORE_CHANNEL_MODE_MPMC = 3
+} core_channel_mode_t;
+
+typedef enum core_channel_wait {
+    CORE_CHANNEL_WAIT_ADAPTIVE = 0,
+    CORE_CHANNEL_WAIT_YIELD    = 1,
+    CORE_CHANNEL_WAIT_SPIN     = 2
+} core_channel_wait_t;
+
+typedef enum core_channel_overload {
+    CORE_CHANNEL_OVERLOAD_BLOCK       = 0,
+    CORE_CHANNEL_OVERLOAD_DROP_NEWEST = 1,
+    CORE_CHANNEL_OVERLOAD_DROP_OLDEST = 2
+} core_channel_overload_t;
+
 typedef struct core_channel {
-    core_log_t        _log;
-    ck_ring_buffer_t* ring_buf;
-    ck_ring_t         ring;
-    int               closed;
-    size_t            capacity;
-
-    core_receiver_t recv;
-    void*           ctx;
+    core_log_t          _log;
+    ck_ring_buffer_t*   ring_buf;
+    ck_ring_t           ring;
+    int                 closed;
+    size_t              capacity;
+    core_channel_mode_t mode;
+    core_channel_wait_t wait;
+    unsigned int        spin;
+
+    core_channel_overload_t overload;
+    int                     free_dropped;
+    int                     overload_fixed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  not_full, not_empty;
+    unsigned int    put_waiters, get_waiters;
+
+    uint64_t put_spins, put_sleeps;
+    uint64_t get_spins, get_sleeps;
+    uint64_t dropped;
+
+    uint64_t     put_stalls, put_stall_time;
+    uint64_t     get_idles, get_idle_time;
+    int          track_occupancy;
+    unsigned int high_water;
+    uint64_t     occupancy[8];
+
+    int notify_fd, notify_wfd, notify_armed;
+    int numa_node;
+
+    core_receiver_t       recv;
+    void*                 ctx;
+    core_receiver_batch_t recv_batch;
 } core_channel_t;
 
+typedef struct core_channel_stats {
+    size_t   capacity, size, high_water;
+    uint64_t occupancy[8];
+    uint64_t put_stalls, put_stall_time, put_spins, put_sleeps;
+    uint64_t get_idles, get_idle_time, get_spins, get_sleeps;
+    uint64_t dropped;
+} core_channel_stats_t;
+
 core_log_t* core_channel_log();
 
 void  core_channel_init(core_channel_t* self, size_t capacity);
+void  core_channel_init_numa(core_channel_t* self, size_t capacity, int node);
 void  core_channel_destroy(core_channel_t* self);
 void  core_channel_put(core_channel_t* self, const void* obj);
 int   core_channel_try_put(core_channel_t* self, const void* obj);
@@ -44,6 +97,17 @@ void* core_channel_try_get(core_channel_t* self);
 int   core_channel_size(core_channel_t* self);
 bool  core_channel_full(core_channel_t* self);
 void  core_channel_close(core_channel_t* self);
+void  core_channel_stats(core_channel_t* self, core_channel_stats_t* stats);
+int   core_channel_notify(core_channel_t* self);
+bool  core_channel_notify_arm(core_channel_t* self);
+void  core_channel_notify_clear(core_channel_t* self);
+
+void   core_channel_put_many(core_channel_t* self, void* const* objs, size_t num);
+size_t core_channel_try_put_many(core_channel_t* self, void* const* objs, size_t num);
+size_t core_channel_get_many(core_channel_t* self, void** objs, size_t num);
+size_t core_channel_try_get_many(core_channel_t* self, void** objs, size_t num);
 
-core_receiver_t core_channel_receiver();
+core_receiver_t       core_channel_receiver();
+core_receiver_batch_t core_channel_receiver_batch();
 void            core_channel_run(core_channel_t* self);
+void            core_channel_run_many(core_channel_t* self, size_t num);
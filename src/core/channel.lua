@@ -33,12 +33,155 @@
 -- A channel can be used to send data to another thread, this is done by
 -- putting a pointer to the data into a wait-free and lock-free ring buffer
 -- (concurrency kit).
--- The channel uses the single producer, single consumer model (SPSC) so
--- there can only be one writer and one reader.
+-- By default the channel uses the single producer, single consumer model
+-- (SPSC) so there can only be one writer and one reader, see
+-- .B MODES
+-- for using multiple writers and/or readers.
+-- .SS Fan-in from multiple threads
+--   local channel = require("dnsjit.core.channel")
+--   local chan = channel.new(4096, channel.MPSC)
+--   for n = 1, 4 do
+--       threads[n]:push(chan)
+--   end
+--   chan:receiver(output)
+--   chan:run()
+-- .SS Batching
+-- Objects can be moved in batches using arrays of pointers, this reserves
+-- room in (or claims entries from) the ring buffer once per batch instead of
+-- once per object.
+--   local ffi = require("ffi")
+--   local objs = ffi.new("void*[?]", 64)
+--   local n = chan:get_many(objs, 64)
+--   for i = 0, n - 1 do
+--       ...
+--   end
+-- .SS Notification
+-- A channel can have a file descriptor that becomes readable when objects
+-- are put into it, this makes it possible to wait on many channels and
+-- sockets at once, see
+-- .BR dnsjit.core.poller (3).
+-- The handle must be enabled with
+-- .IR notify ()
+-- (or by adding the channel to a poller) before the channel is shared
+-- with other threads.
+-- .SS MODES
+-- The mode is given when creating the channel and can not be changed.
+-- .TP
+-- SPSC
+-- Single producer, single consumer (default).
+-- .TP
+-- MPSC
+-- Multiple producers, single consumer.
+-- .TP
+-- SPMC
+-- Single producer, multiple consumers.
+-- .TP
+-- MPMC
+-- Multiple producers, multiple consumers.
+-- .SS WAITING
+-- When the channel is full (for producers) or empty (for consumers) the
+-- calling thread has to wait, how it waits can be set per channel with the
+-- .I wait
+-- attribute.
+-- .TP
+-- ADAPTIVE
+-- Spin for
+-- .I spin
+-- iterations and then sleep until the other side signals that it has put
+-- or got an object (default).
+-- .TP
+-- YIELD
+-- Yield the CPU to other threads with
+-- .IR sched_yield ()
+-- and try again, never sleeps.
+-- .TP
+-- SPIN
+-- Busy-wait and never sleep, lowest latency but uses a whole core.
+-- .LP
+--   local chan = channel.new()
+--   chan.wait = channel.ADAPTIVE
+--   chan.spin = 10000
+-- .SS OVERLOAD
+-- What happens when putting objects into a full channel can be set per
+-- channel with the
+-- .I overload
+-- attribute, this only affects
+-- .IR put ()
+-- and
+-- .IR put_many ()
+-- (and so also when the channel is used as a receiver).
+-- .TP
+-- BLOCK
+-- Wait until space becomes available (default).
+-- .TP
+-- DROP_NEWEST
+-- Drop the object(s) being put.
+-- .TP
+-- DROP_OLDEST
+-- Drop the oldest object(s) in the channel to make room, this makes the
+-- consumer side of the channel use multi consumer operations.
+-- .LP
+-- Dropped objects are counted in
+-- .I dropped
+-- and if
+-- .I free_dropped
+-- is set they are also freed, which should be used when putting copies of
+-- objects into the channel.
+--   local chan = channel.new(4096)
+--   chan.overload = channel.DROP_NEWEST
+--   chan.free_dropped = 1
+--   copy:receiver(chan)
+--   ...
+--   print(tonumber(chan.dropped))
 -- .SS Attributes
 -- .TP
 -- int closed
 -- Is 1 if the channel has been closed.
+-- .TP
+-- mode
+-- The producer/consumer mode of the channel.
+-- .TP
+-- wait
+-- The wait strategy of the channel, see
+-- .BR WAITING .
+-- .TP
+-- spin
+-- Number of spins before sleeping when using the ADAPTIVE wait strategy,
+-- default 1000.
+-- .TP
+-- overload
+-- The overload policy of the channel, see
+-- .BR OVERLOAD .
+-- Must be set before the first put, changing it after is fatal.
+-- .TP
+-- int free_dropped
+-- If 1, free dropped objects using
+-- .IR core_object_free ().
+-- .TP
+-- put_spins, put_sleeps
+-- Number of spins (or yields) and number of sleeps producers have done
+-- waiting for space in the channel.
+-- .TP
+-- get_spins, get_sleeps
+-- Number of spins (or yields) and number of sleeps consumers have done
+-- waiting for objects in the channel.
+-- .TP
+-- dropped
+-- Number of objects dropped because of the overload policy or because the
+-- channel was closed while full.
+-- .TP
+-- put_stalls, put_stall_time
+-- Number of times producers had to wait and the total time (nanoseconds)
+-- they waited.
+-- .TP
+-- get_idles, get_idle_time
+-- Number of times consumers had to wait and the total time (nanoseconds)
+-- they waited.
+-- .TP
+-- int track_occupancy
+-- If 1, record the high-water mark and an occupancy histogram of the
+-- channel on each put, see
+-- .IR stats ().
 module(...,package.seeall)
 
 require("dnsjit.core.channel_h")
@@ -47,19 +190,49 @@ local C = ffi.C
 
 local t_name = "core_channel_t"
 local core_channel_t
-local Channel = {}
+local Channel = {
+    SPSC = "CORE_CHANNEL_MODE_SPSC",
+    MPSC = "CORE_CHANNEL_MODE_MPSC",
+    SPMC = "CORE_CHANNEL_MODE_SPMC",
+    MPMC = "CORE_CHANNEL_MODE_MPMC",
+    ADAPTIVE = "CORE_CHANNEL_WAIT_ADAPTIVE",
+    YIELD = "CORE_CHANNEL_WAIT_YIELD",
+    SPIN = "CORE_CHANNEL_WAIT_SPIN",
+    BLOCK = "CORE_CHANNEL_OVERLOAD_BLOCK",
+    DROP_NEWEST = "CORE_CHANNEL_OVERLOAD_DROP_NEWEST",
+    DROP_OLDEST = "CORE_CHANNEL_OVERLOAD_DROP_OLDEST",
+}
 
 -- Create a new Channel, use the optional
 -- .I capacity
--- to specify the capacity of the channel (buffer).
+-- to specify the capacity of the channel (buffer) and the optional
+-- .I mode
+-- to specify the producer/consumer mode (see
+-- .BR MODES ).
 -- Capacity must be a power-of-two greater than or equal to 4.
--- Default capacity is 2048.
-function Channel.new(capacity)
+-- Default capacity is 2048 and default mode is SPSC.
+-- The optional
+-- .I node
+-- is the NUMA node to allocate the ring buffer on, which should be the
+-- node of the consuming thread, it can also be given as the consuming
+-- Thread object (see
+-- .BR dnsjit.core.thread (3)).
+function Channel.new(capacity, mode, node)
     if capacity == nil then
         capacity = 2048
     end
     local self = core_channel_t()
-    C.core_channel_init(self, capacity)
+    if node == nil then
+        C.core_channel_init(self, capacity)
+    else
+        if type(node) ~= "number" then
+            node = node.numa_node
+        end
+        C.core_channel_init_numa(self, capacity, node)
+    end
+    if mode ~= nil then
+        self.mode = mode
+    end
     ffi.gc(self, C.core_channel_destroy)
     return self
 end
@@ -79,6 +252,7 @@ end
 
 -- Put an object into the channel, if the channel is full then it will
 -- stall and wait until space becomes available.
+-- If the channel is closed while full the object is dropped.
 -- Object may be nil.
 function Channel:put(obj)
     C.core_channel_put(self, obj)
@@ -86,8 +260,8 @@ end
 
 -- Try and put an object into the channel.
 -- Returns 0 on success.
-function Channel:put(obj)
-    C.core_channel_try_put(self, obj)
+function Channel:try_put(obj)
+    return C.core_channel_try_put(self, obj)
 end
 
 -- Get an object from the channel, if the channel is empty it will wait until
@@ -104,6 +278,49 @@ function Channel:try_get()
     return C.core_channel_try_get(self)
 end
 
+-- Put
+-- .I num
+-- objects from the array
+-- .I objs
+-- (a
+-- .IR void*[?] )
+-- into the channel, if the channel is full then it will stall and wait until
+-- space becomes available.
+-- If the channel is closed while full the remaining objects are dropped.
+function Channel:put_many(objs, num)
+    C.core_channel_put_many(self, objs, num)
+end
+
+-- Try and put up to
+-- .I num
+-- objects from the array
+-- .I objs
+-- into the channel.
+-- Returns the number of objects put, which may be less than
+-- .IR num .
+function Channel:try_put_many(objs, num)
+    return tonumber(C.core_channel_try_put_many(self, objs, num))
+end
+
+-- Get up to
+-- .I num
+-- objects from the channel into the array
+-- .IR objs ,
+-- if the channel is empty it will wait until objects are available.
+-- Returns the number of objects retrieved or 0 if the channel is closed.
+function Channel:get_many(objs, num)
+    return tonumber(C.core_channel_get_many(self, objs, num))
+end
+
+-- Try and get up to
+-- .I num
+-- objects from the channel into the array
+-- .IR objs .
+-- Returns the number of objects retrieved, 0 if there was no objects to get.
+function Channel:try_get_many(objs, num)
+    return tonumber(C.core_channel_try_get_many(self, objs, num))
+end
+
 -- Return number of enqueued objects.
 function Channel:size()
     return C.core_channel_size(self)
@@ -114,29 +331,106 @@ function Channel:full()
     return C.core_channel_full(self)
 end
 
--- Close the channel.
+-- Return a table with the statistics of the channel, this can be called
+-- from any thread without locking the channel.
+-- The table contains
+-- .IR capacity ,
+-- .IR size ,
+-- .I high_water
+-- (the highest number of enqueued objects),
+-- .I occupancy
+-- (a table with the number of puts after which the channel was 0-12.5%,
+-- 12.5-25% and so on full),
+-- the counters described under
+-- .B Attributes
+-- and
+-- .IR put_stall_avg / get_idle_avg ,
+-- the average time in nanoseconds of a stall/idle period.
+-- The high-water mark and occupancy are only recorded if
+-- .I track_occupancy
+-- is set.
+function Channel:stats()
+    local stats = ffi.new("core_channel_stats_t")
+    C.core_channel_stats(self, stats)
+    local ret = {
+        capacity = tonumber(stats.capacity),
+        size = tonumber(stats.size),
+        high_water = tonumber(stats.high_water),
+        occupancy = {},
+    }
+    for i = 0, 7 do
+        ret.occupancy[i + 1] = tonumber(stats.occupancy[i])
+    end
+    for _, n in pairs({ "put_stalls", "put_stall_time", "put_spins", "put_sleeps",
+                        "get_idles", "get_idle_time", "get_spins", "get_sleeps", "dropped" }) do
+        ret[n] = tonumber(stats[n])
+    end
+    ret.put_stall_avg = ret.put_stalls > 0 and ret.put_stall_time / ret.put_stalls or 0
+    ret.get_idle_avg = ret.get_idles > 0 and ret.get_idle_time / ret.get_idles or 0
+    return ret
+end
+
+-- Close the channel, this wakes up all consumers and producers waiting on it.
 function Channel:close()
     C.core_channel_close(self)
 end
 
+-- Enable the notification handle of the channel, returns the file
+-- descriptor to poll for readability or -1 on error.
+-- Once enabled, each time the consumer arms the handle (see
+-- .BR dnsjit.core.poller (3))
+-- the next put will signal it.
+function Channel:notify()
+    return C.core_channel_notify(self)
+end
+
 -- Return the C functions and context for receiving objects.
 function Channel:receive()
     return C.core_channel_receiver(), self
 end
 
--- Set the receiver to pass objects to.
+-- Return the C function and context for receiving batches of objects.
+function Channel:receive_batch()
+    return C.core_channel_receiver_batch(), self
+end
+
+-- Set the receiver to pass objects to, if the receiver has a batch receiver
+-- it is used by
+-- .IR run ()
+-- when given a
+-- .IR num .
 -- NOTE; The channel keeps no reference of the receiver, it needs to live as
 -- long as the channel does.
 function Channel:receiver(o)
     self.recv, self.ctx = o:receive()
+    if o.receive_batch then
+        self.recv_batch = o:receive_batch()
+    else
+        self.recv_batch = nil
+    end
 end
 
 -- Retrieve all objects from the channel and send it to the receiver.
-function Channel:run()
-    C.core_channel_run(self)
+-- With the SPMC and MPMC modes this can be called from multiple threads to
+-- spread the objects over them.
+--
+-- If
+-- .I num
+-- is given then up to that many objects are retrieved from the channel at a
+-- time and then sent to the receiver one by one, or as one batch if the
+-- receiver has a batch receiver, reducing the synchronization on the ring
+-- buffer when there is a steady flow of objects.
+function Channel:run(num)
+    if num then
+        C.core_channel_run_many(self, num)
+    else
+        C.core_channel_run(self)
+    end
 end
 
 core_channel_t = ffi.metatype(t_name, { __index = Channel })
 
+-- dnsjit.core.broadcast (3),
+-- dnsjit.core.poller (3),
 -- dnsjit.core.thread (3)
 return Channel
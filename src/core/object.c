@@ -38,6 +38,12 @@
 #include "core/object/tcp.h"
 #include "core/object/payload.h"
 #include "core/object/dns.h"
+#include "core/object/packet.h"
+#include "core/pool.h"
+
+#include <string.h>
+
+#define CHAIN_ALIGN(n) (((n) + 7) & ~(size_t)7)
 
 core_object_t* core_object_copy(const core_object_t* self)
 {
@@ -76,6 +82,8 @@ core_object_t* core_object_copy(const core_object_t* self)
         return (core_object_t*)core_object_payload_copy((core_object_payload_t*)self);
     case CORE_OBJECT_DNS:
         return (core_object_t*)core_object_dns_copy((core_object_dns_t*)self);
+    case CORE_OBJECT_PACKET:
+        return (core_object_t*)core_object_packet_copy((core_object_packet_t*)self);
     default:
         glfatal("unknown type %d", self->obj_type);
     }
@@ -135,7 +143,258 @@ void core_object_free(core_object_t* self)
     case CORE_OBJECT_DNS:
         core_object_dns_free((core_object_dns_t*)self);
         break;
+    case CORE_OBJECT_PACKET:
+        core_object_packet_free((core_object_packet_t*)self);
+        break;
     default:
         glfatal("unknown type %d", self->obj_type);
     }
 }
+
+/*
+ * Return the size of the object structure and set extra to the size of any
+ * data that is carried with the object when copied (pcap bytes, payload).
+ */
+static size_t _size(const core_object_t* self, size_t* extra)
+{
+    *extra = 0;
+
+    switch (self->obj_type) {
+    case CORE_OBJECT_PCAP:
+        if (((core_object_pcap_t*)self)->bytes) {
+            *extra = ((core_object_pcap_t*)self)->caplen;
+        }
+        return sizeof(core_object_pcap_t);
+    case CORE_OBJECT_ETHER:
+        return sizeof(core_object_ether_t);
+    case CORE_OBJECT_NULL:
+        return sizeof(core_object_null_t);
+    case CORE_OBJECT_LOOP:
+        return sizeof(core_object_loop_t);
+    case CORE_OBJECT_LINUXSLL:
+        return sizeof(core_object_linuxsll_t);
+    case CORE_OBJECT_IEEE802:
+        return sizeof(core_object_ieee802_t);
+    case CORE_OBJECT_GRE:
+        return sizeof(core_object_gre_t);
+    case CORE_OBJECT_LINUXSLL2:
+        return sizeof(core_object_linuxsll2_t);
+    case CORE_OBJECT_IP:
+        return sizeof(core_object_ip_t);
+    case CORE_OBJECT_IP6:
+        return sizeof(core_object_ip6_t);
+    case CORE_OBJECT_ICMP:
+        return sizeof(core_object_icmp_t);
+    case CORE_OBJECT_ICMP6:
+        return sizeof(core_object_icmp6_t);
+    case CORE_OBJECT_UDP:
+        return sizeof(core_object_udp_t);
+    case CORE_OBJECT_TCP:
+        return sizeof(core_object_tcp_t);
+    case CORE_OBJECT_PAYLOAD:
+        if (((core_object_payload_t*)self)->payload) {
+            *extra = ((core_object_payload_t*)self)->len + ((core_object_payload_t*)self)->padding;
+        }
+        return sizeof(core_object_payload_t);
+    case CORE_OBJECT_DNS:
+        return sizeof(core_object_dns_t);
+    case CORE_OBJECT_PACKET:
+        return sizeof(core_object_packet_t);
+    default:
+        glfatal("unknown type %d", self->obj_type);
+    }
+    return 0;
+}
+
+/*
+ * Copy the object into memory of at least size + extra bytes, the carried
+ * data is placed directly after the object structure.
+ */
+static void _copy_into(core_object_t* copy, const core_object_t* self, size_t size, size_t extra)
+{
+    memcpy(copy, self, size);
+    copy->obj_prev = 0;
+
+    if (self->obj_type == CORE_OBJECT_PACKET) {
+        ((core_object_packet_t*)copy)->pcap      = 0;
+        ((core_object_packet_t*)copy)->link      = 0;
+        ((core_object_packet_t*)copy)->ip        = 0;
+        ((core_object_packet_t*)copy)->transport = 0;
+        ((core_object_packet_t*)copy)->payload   = 0;
+    }
+    if (!extra) {
+        return;
+    }
+    switch (self->obj_type) {
+    case CORE_OBJECT_PCAP:
+        ((core_object_pcap_t*)copy)->bytes = (uint8_t*)copy + size;
+        memcpy((void*)((core_object_pcap_t*)copy)->bytes, ((core_object_pcap_t*)self)->bytes, extra);
+        break;
+    case CORE_OBJECT_PAYLOAD:
+        ((core_object_payload_t*)copy)->payload = (uint8_t*)copy + size;
+        memcpy((void*)((core_object_payload_t*)copy)->payload, ((core_object_payload_t*)self)->payload, extra);
+        break;
+    }
+}
+
+core_object_t* core_object_copy_pool(const core_object_t* self, core_pool_t* pool)
+{
+    core_object_t* copy;
+    size_t         size, extra;
+    glassert_self();
+
+    if (!pool) {
+        return core_object_copy(self);
+    }
+
+    size = _size(self, &extra);
+    glfatal_oom(copy = core_pool_alloc(pool, size + extra));
+    _copy_into(copy, self, size, extra);
+
+    return copy;
+}
+
+/*
+ * Return the location in the copy of a pointer into source data that has
+ * been copied, or the pointer itself if it points elsewhere.
+ */
+static inline const uint8_t* _relocate(const uint8_t* ptr, const uint8_t* from, size_t len, const uint8_t* to)
+{
+    if (ptr && from && to && ptr >= from && ptr <= from + len) {
+        return to + (ptr - from);
+    }
+    return ptr;
+}
+
+/*
+ * Return the copy of the object pointed to within a copied chain, or nil if
+ * it was not part of the copy.
+ */
+static const void* _remap(const void* ptr, const core_object_t* self, const core_object_t* out, uint64_t types)
+{
+    for (; ptr && self; self = self->obj_prev) {
+        if (!(types & ((uint64_t)1 << self->obj_type))) {
+            continue;
+        }
+        if ((const void*)self == ptr) {
+            return out;
+        }
+        out = out->obj_prev;
+    }
+    return 0;
+}
+
+core_object_t* core_object_copy_chain(const core_object_t* self, uint64_t types, core_pool_t* pool)
+{
+    const core_object_t*         src;
+    const core_object_pcap_t*    pcap    = 0;
+    const core_object_payload_t* payload = 0;
+    core_object_pcap_t*          pcap_copy    = 0;
+    core_object_payload_t*       payload_copy = 0;
+    core_object_dns_t*           dns_copy     = 0;
+    const core_object_packet_t*  packet       = 0;
+    core_object_packet_t*        packet_copy  = 0;
+    core_object_t *              copy, *prev = 0, *out;
+    uint8_t*                     at;
+    size_t                       size, extra, total = 0;
+    int                          shared = 0;
+    glassert_self();
+
+    for (src = self; src; src = src->obj_prev) {
+        if (src->obj_type == CORE_OBJECT_PCAP && (types & ((uint64_t)1 << CORE_OBJECT_PCAP))) {
+            pcap = (core_object_pcap_t*)src;
+            break;
+        }
+    }
+
+    for (src = self; src; src = src->obj_prev) {
+        if (!(types & ((uint64_t)1 << src->obj_type))) {
+            continue;
+        }
+        size = _size(src, &extra);
+        if (src->obj_type == CORE_OBJECT_PAYLOAD && extra && pcap && pcap->bytes && !payload) {
+            payload = (core_object_payload_t*)src;
+            // payload within the packet only needs the packet bytes copied
+            if (payload->payload >= pcap->bytes && payload->payload + extra <= pcap->bytes + pcap->caplen) {
+                shared = 1;
+                extra  = 0;
+            }
+        }
+        total += CHAIN_ALIGN(size + extra);
+    }
+    if (!total) {
+        return 0;
+    }
+
+    glfatal_oom(out = core_pool_alloc(pool, total));
+    at = (uint8_t*)out;
+
+    for (src = self; src; src = src->obj_prev) {
+        if (!(types & ((uint64_t)1 << src->obj_type))) {
+            continue;
+        }
+        copy = (core_object_t*)at;
+        size = _size(src, &extra);
+        if ((void*)src == payload) {
+            payload_copy = (core_object_payload_t*)copy;
+            if (shared) {
+                extra = 0;
+            }
+        } else if ((void*)src == pcap) {
+            pcap_copy = (core_object_pcap_t*)copy;
+        } else if (src->obj_type == CORE_OBJECT_PAYLOAD && !payload) {
+            payload      = (core_object_payload_t*)src;
+            payload_copy = (core_object_payload_t*)copy;
+        } else if (src->obj_type == CORE_OBJECT_DNS && !dns_copy) {
+            dns_copy = (core_object_dns_t*)copy;
+        } else if (src->obj_type == CORE_OBJECT_PACKET && !packet_copy) {
+            packet      = (core_object_packet_t*)src;
+            packet_copy = (core_object_packet_t*)copy;
+        }
+        _copy_into(copy, src, size, extra);
+        if (prev) {
+            prev->obj_prev = copy;
+        }
+        prev = copy;
+        at += CHAIN_ALIGN(size + extra);
+    }
+
+    if (shared) {
+        payload_copy->payload = _relocate(payload->payload, pcap->bytes, pcap->caplen, pcap_copy->bytes);
+    }
+    if (dns_copy) {
+        if (payload_copy) {
+            dns_copy->payload = _relocate(dns_copy->payload, payload->payload, payload->len + payload->padding, payload_copy->payload);
+            dns_copy->at      = _relocate(dns_copy->at, payload->payload, payload->len + payload->padding, payload_copy->payload);
+        } else if (pcap_copy) {
+            dns_copy->payload = _relocate(dns_copy->payload, pcap->bytes, pcap->caplen, pcap_copy->bytes);
+            dns_copy->at      = _relocate(dns_copy->at, pcap->bytes, pcap->caplen, pcap_copy->bytes);
+        }
+    }
+    if (packet_copy) {
+        packet_copy->pcap      = _remap(packet->pcap, self, out, types);
+        packet_copy->link      = _remap(packet->link, self, out, types);
+        packet_copy->ip        = _remap(packet->ip, self, out, types);
+        packet_copy->transport = _remap(packet->transport, self, out, types);
+        packet_copy->payload   = _remap(packet->payload, self, out, types);
+    }
+
+    return out;
+}
+
+core_object_t* core_object_retain(core_object_t* self)
+{
+    glassert_self();
+
+    core_pool_retain(self);
+    return self;
+}
+
+void core_object_release(core_object_t* self)
+{
+    glassert_self();
+
+    if (core_pool_release(self)) {
+        core_object_free(self);
+    }
+}
@@ -43,8 +43,11 @@
 #define CORE_OBJECT_PAYLOAD 40
 /* service object(s) */
 #define CORE_OBJECT_DNS 50
+/* packet context */
+#define CORE_OBJECT_PACKET 60
 
 #include <stdint.h>
+#include <dnsjit/core/pool.h>
 #include <dnsjit/core/object.hh>
 
 #define CORE_OBJECT_INIT(type, prev) (core_object_t*)prev, type
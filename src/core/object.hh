@@ -18,6 +18,8 @@
  * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// lua:require("dnsjit.core.pool_h")
+
 typedef struct core_object core_object_t;
 struct core_object {
     const core_object_t* obj_prev;
@@ -26,3 +28,7 @@ struct core_object {
 
 core_object_t* core_object_copy(const core_object_t* self);
 void           core_object_free(core_object_t* self);
+core_object_t* core_object_copy_pool(const core_object_t* self, core_pool_t* pool);
+core_object_t* core_object_copy_chain(const core_object_t* self, uint64_t types, core_pool_t* pool);
+core_object_t* core_object_retain(core_object_t* self);
+void           core_object_release(core_object_t* self);
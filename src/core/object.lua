@@ -26,6 +26,28 @@
 -- describe a DNS message, how it was captured or generated.
 -- Objects can be chained together, for example a DNS message is created
 -- ontop of a packet.
+-- .SS Sharing copies
+-- Copies of objects carry a reference count, starting at one, so that one
+-- copy can be handed to several receivers or threads.
+-- Each additional holder is added with
+-- .IR retain ()
+-- and every holder calls
+-- .IR release ()
+-- when done, the copy is freed by the last release.
+-- Release frees the object as
+-- .IR free ()
+-- would so a whole chain is shared by copying it with
+-- .IR copy_chain ().
+--   local copy = obj:copy_chain()
+--   copy:retain()
+--   chan1:put(copy)
+--   chan2:put(copy)
+--   ...
+--   -- in each consumer, once per holder
+--   copy:release()
+-- .LP
+-- Only copies can be retained and released, objects produced by inputs
+-- and filters have no reference count and doing so on them is fatal.
 -- .SS Attributes
 -- .TP
 -- obj_type
@@ -52,6 +74,7 @@ require("dnsjit.core.object.udp_h")
 require("dnsjit.core.object.tcp_h")
 require("dnsjit.core.object.payload_h")
 require("dnsjit.core.object.dns_h")
+require("dnsjit.core.object.packet_h")
 local ffi = require("ffi")
 local C = ffi.C
 
@@ -74,7 +97,8 @@ local Object = {
     UDP = 30,
     TCP = 31,
     PAYLOAD = 40,
-    DNS = 50
+    DNS = 50,
+    PACKET = 60
 }
 
 local _type = {}
@@ -94,6 +118,7 @@ _type[Object.UDP] = "udp"
 _type[Object.TCP] = "tcp"
 _type[Object.PAYLOAD] = "payload"
 _type[Object.DNS] = "dns"
+_type[Object.PACKET] = "packet"
 
 _type[Object.NONE] = "none"
 
@@ -124,6 +149,7 @@ _cast[Object.UDP] = "core_object_udp_t*"
 _cast[Object.TCP] = "core_object_tcp_t*"
 _cast[Object.PAYLOAD] = "core_object_payload_t*"
 _cast[Object.DNS] = "core_object_dns_t*"
+_cast[Object.PACKET] = "core_object_packet_t*"
 
 -- Cast the object to the underlining object module and return it.
 function Object:cast()
@@ -151,11 +177,47 @@ function Object:uncast()
     return self
 end
 
--- Make a copy of the object and return it.
-function Object:copy()
+-- Make a copy of the object and return it, the copy is allocated from the
+-- optional
+-- .BR dnsjit.core.pool (3)
+-- if given.
+function Object:copy(pool)
+    if pool then
+        return C.core_object_copy_pool(self, pool)
+    end
     return C.core_object_copy(self)
 end
 
+-- Make a copy of the object and all objects before it in one allocation,
+-- optionally from a
+-- .BR dnsjit.core.pool (3)
+-- and only of the given object types, and return it.
+-- Pointers to packet and payload bytes within the chain are adjusted to
+-- point into the copy.
+-- The copy is freed with
+-- .IR free ()
+-- on the returned object only.
+function Object:copy_chain(pool, ...)
+    local types = 0ULL
+    for _, obj_type in pairs({...}) do
+        types = bit.bor(types, bit.lshift(1ULL, obj_type))
+    end
+    if types == 0ULL then
+        types = bit.bnot(0ULL)
+    end
+    return C.core_object_copy_chain(self, types, pool)
+end
+
+-- Add a reference to a copied object and return it.
+function Object:retain()
+    return C.core_object_retain(self)
+end
+
+-- Drop a reference to a copied object, freeing it if it was the last.
+function Object:release()
+    C.core_object_release(self)
+end
+
 -- Free the object, should only be used on copies or otherwise allocated.
 function Object:free()
     C.core_object_free(self)
@@ -178,5 +240,7 @@ core_object_t = ffi.metatype(t_name, { __index = Object })
 -- dnsjit.core.object.udp (3),
 -- dnsjit.core.object.tcp (3),
 -- dnsjit.core.object.payload (3),
--- dnsjit.core.object.dns (3)
+-- dnsjit.core.object.dns (3),
+-- dnsjit.core.object.packet (3),
+-- dnsjit.core.pool (3)
 return Object
@@ -22,7 +22,9 @@
 
 #include "core/object/dns.h"
 #include "core/object/payload.h"
+#include "core/object/packet.h"
 #include "core/assert.h"
+#include "core/pool.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -52,9 +54,14 @@
 #endif
 #endif
 #include <ctype.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define _ERR_MALFORMED -2
 #define _ERR_NEEDLABELS -3
+#define _ERR_NEEDRRS -4
+#define _ERR_NEEDSPACE -5
 
 static core_log_t        _log      = LOG_T_INIT("core.object.dns");
 static core_object_dns_t _defaults = CORE_OBJECT_DNS_INIT(0);
@@ -62,6 +69,7 @@ static core_object_dns_t _defaults = CORE_OBJECT_DNS_INIT(0);
 static core_object_dns_label_t _defaults_label = { 0 };
 static core_object_dns_rr_t    _defaults_rr    = { 0 };
 static core_object_dns_q_t     _defaults_q     = { 0 };
+static core_object_dns_edns_t  _defaults_edns  = { 0 };
 
 core_log_t* core_object_dns_log()
 {
@@ -72,7 +80,7 @@ core_object_dns_t* core_object_dns_new()
 {
     core_object_dns_t* self;
 
-    mlfatal_oom(self = malloc(sizeof(core_object_dns_t)));
+    mlfatal_oom(self = core_pool_alloc(0, sizeof(core_object_dns_t)));
     *self = _defaults;
 
     return self;
@@ -83,7 +91,7 @@ core_object_dns_t* core_object_dns_copy(const core_object_dns_t* self)
     core_object_dns_t* copy;
     mlassert_self();
 
-    mlfatal_oom(copy = malloc(sizeof(core_object_dns_t)));
+    mlfatal_oom(copy = core_pool_alloc(0, sizeof(core_object_dns_t)));
     memcpy(copy, self, sizeof(core_object_dns_t));
     copy->obj_prev = 0;
 
@@ -93,7 +101,7 @@ core_object_dns_t* core_object_dns_copy(const core_object_dns_t* self)
 void core_object_dns_free(core_object_dns_t* self)
 {
     mlassert_self();
-    free(self);
+    core_pool_free(self);
 }
 
 void core_object_dns_reset(core_object_dns_t* self)
@@ -161,7 +169,10 @@ int core_object_dns_parse_header(core_object_dns_t* self)
     uint8_t                      byte;
     mlassert_self();
 
-    if (!(payload = (core_object_payload_t*)self->obj_prev) || payload->obj_type != CORE_OBJECT_PAYLOAD) {
+    if ((payload = (core_object_payload_t*)self->obj_prev) && payload->obj_type == CORE_OBJECT_PACKET) {
+        payload = ((const core_object_packet_t*)payload)->payload;
+    }
+    if (!payload || payload->obj_type != CORE_OBJECT_PAYLOAD) {
         mlfatal("no obj_prev or invalid type");
     }
     if (!payload->payload || !payload->len) {
@@ -477,6 +488,752 @@ int core_object_dns_parse_rr(core_object_dns_t* self, core_object_dns_rr_t* rr,
     return _ERR_MALFORMED;
 }
 
+/*
+ * Skip over a name without storing the labels, returns non-zero if it is
+ * malformed or truncated.
+ */
+static inline int _skip_name(core_object_dns_t* self)
+{
+    uint8_t length;
+
+    for (;;) {
+        need8(length, self->at, self->left);
+        if ((length & 0xc0) == 0xc0) {
+            advancexb(1, self->at, self->left);
+            return 0;
+        } else if (length & 0xc0) {
+            break;
+        } else if (!length) {
+            return 0;
+        }
+        advancexb(length, self->at, self->left);
+    }
+
+    return 1;
+}
+
+int core_object_dns_parse_edns(core_object_dns_t* self, core_object_dns_edns_t* edns)
+{
+    uint16_t type, class, rdlength, code, len;
+    uint32_t ttl;
+    size_t   n, rrs;
+    int      ret;
+    mlassert_self();
+    mlassert(edns, "edns is nil");
+
+    *edns = _defaults_edns;
+
+    if ((ret = core_object_dns_parse_header(self))) {
+        return ret;
+    }
+    if (!self->arcount) {
+        return 0;
+    }
+
+    for (n = 0; n < self->qdcount; n++) {
+        if (_skip_name(self)) {
+            return _ERR_MALFORMED;
+        }
+        if (self->left < 4) {
+            return _ERR_MALFORMED;
+        }
+        self->at += 4;
+        self->left -= 4;
+    }
+
+    rrs = (size_t)self->ancount + self->nscount + self->arcount;
+    for (n = 0; n < rrs; n++) {
+        if (_skip_name(self) || self->left < 10) {
+            return _ERR_MALFORMED;
+        }
+        type     = _need16(self->at);
+        class    = _need16(self->at + 2);
+        ttl      = _need32(self->at + 4);
+        rdlength = _need16(self->at + 8);
+        self->at += 10;
+        self->left -= 10;
+        if (rdlength > self->left) {
+            return _ERR_MALFORMED;
+        }
+
+        if (type == CORE_OBJECT_DNS_TYPE_OPT && n >= rrs - self->arcount) {
+            edns->have_opt       = 1;
+            edns->udp_size       = class;
+            edns->extended_rcode = ttl >> 24;
+            edns->version        = (ttl >> 16) & 0xff;
+            edns->flags          = ttl & 0xffff;
+            edns->dnssec_ok      = ttl & 0x8000 ? 1 : 0;
+            edns->rdata_offset   = self->at - self->payload;
+            edns->rdlength       = rdlength;
+            edns->at             = edns->rdata_offset;
+            break;
+        }
+
+        self->at += rdlength;
+        self->left -= rdlength;
+    }
+    if (!edns->have_opt) {
+        return 0;
+    }
+
+    /* summarize the options present */
+    for (n = edns->rdata_offset; n + 4 <= edns->rdata_offset + edns->rdlength;) {
+        code = _need16(self->payload + n);
+        len  = _need16(self->payload + n + 2);
+        n += 4 + len;
+        if (n > edns->rdata_offset + edns->rdlength) {
+            return _ERR_MALFORMED;
+        }
+        switch (code) {
+        case CORE_OBJECT_DNS_EDNS0_OPT_CLIENT_SUBNET:
+            edns->have_ecs = 1;
+            break;
+        case CORE_OBJECT_DNS_EDNS0_OPT_COOKIE:
+            edns->have_cookie = 1;
+            break;
+        case CORE_OBJECT_DNS_EDNS0_OPT_PADDING:
+            edns->have_padding = 1;
+            break;
+        case CORE_OBJECT_DNS_EDNS0_OPT_EDE:
+            edns->have_ede = 1;
+            break;
+        }
+        edns->options++;
+    }
+    if (n != edns->rdata_offset + edns->rdlength) {
+        return _ERR_MALFORMED;
+    }
+
+    return 0;
+}
+
+int core_object_dns_edns_next(const core_object_dns_t* self, core_object_dns_edns_t* edns, core_object_dns_edns_opt_t* opt)
+{
+    const uint8_t* at;
+    size_t         end;
+    mlassert_self();
+    mlassert(edns, "edns is nil");
+    mlassert(opt, "opt is nil");
+
+    end = edns->rdata_offset + edns->rdlength;
+    if (!edns->have_opt || edns->at >= end) {
+        return 1;
+    }
+    if (edns->at + 4 > end) {
+        return _ERR_MALFORMED;
+    }
+
+    at = self->payload + edns->at;
+    memset(opt, 0, sizeof(core_object_dns_edns_opt_t));
+    opt->code = _need16(at);
+    opt->len  = _need16(at + 2);
+    opt->data = at + 4;
+    if (edns->at + 4 + opt->len > end) {
+        return _ERR_MALFORMED;
+    }
+
+    switch (opt->code) {
+    case CORE_OBJECT_DNS_EDNS0_OPT_CLIENT_SUBNET:
+        if (opt->len < 4 || opt->len - 4 > sizeof(opt->ecs_address)) {
+            return _ERR_MALFORMED;
+        }
+        opt->ecs_family        = _need16(opt->data);
+        opt->ecs_source_prefix = opt->data[2];
+        opt->ecs_scope_prefix  = opt->data[3];
+        memcpy(opt->ecs_address, opt->data + 4, opt->len - 4);
+        break;
+    case CORE_OBJECT_DNS_EDNS0_OPT_EDE:
+        if (opt->len < 2) {
+            return _ERR_MALFORMED;
+        }
+        opt->ede_code = _need16(opt->data);
+        break;
+    }
+
+    edns->at += 4 + opt->len;
+    return 0;
+}
+
+core_object_dns_msg_t* core_object_dns_msg_new(size_t rrs, size_t labels)
+{
+    core_object_dns_msg_t* msg;
+    uint8_t*               at;
+    mlassert(rrs, "rrs is zero");
+    mlassert(labels, "labels is zero");
+
+    /* one allocation, arrays ordered by alignment */
+    mlfatal_oom(msg = malloc(sizeof(core_object_dns_msg_t)
+                             + rrs * (sizeof(size_t) * 4 + sizeof(uint32_t) + sizeof(uint16_t) * 3 + sizeof(uint8_t))
+                             + labels * sizeof(core_object_dns_label_t)));
+    memset(msg, 0, sizeof(core_object_dns_msg_t));
+    msg->rrs_size    = rrs;
+    msg->labels_size = labels;
+
+    at                     = (uint8_t*)msg + sizeof(core_object_dns_msg_t);
+    msg->rdata_offset      = (size_t*)at;
+    msg->first_label       = msg->rdata_offset + rrs;
+    msg->label_count       = msg->first_label + rrs;
+    msg->rdata_label_count = msg->label_count + rrs;
+    msg->ttl               = (uint32_t*)(msg->rdata_label_count + rrs);
+    msg->type              = (uint16_t*)(msg->ttl + rrs);
+    msg->class             = msg->type + rrs;
+    msg->rdlength          = msg->class + rrs;
+    msg->label             = (core_object_dns_label_t*)(msg->rdlength + rrs);
+    msg->section           = (uint8_t*)(msg->label + labels);
+
+    return msg;
+}
+
+void core_object_dns_msg_free(core_object_dns_msg_t* msg)
+{
+    free(msg);
+}
+
+static inline int _parse_section(core_object_dns_t* self, core_object_dns_msg_t* msg, uint8_t section, uint16_t count, uint16_t* parsed)
+{
+    core_object_dns_q_t  q;
+    core_object_dns_rr_t rr;
+    size_t               n;
+    int                  ret;
+
+    for (n = 0; n < count; n++) {
+        if (msg->rrs >= msg->rrs_size) {
+            return _ERR_NEEDRRS;
+        }
+        if (msg->labels >= msg->labels_size) {
+            return _ERR_NEEDLABELS;
+        }
+
+        msg->section[msg->rrs]     = section;
+        msg->first_label[msg->rrs] = msg->labels;
+
+        if (section == CORE_OBJECT_DNS_SECTION_QUESTION) {
+            if ((ret = core_object_dns_parse_q(self, &q, &msg->label[msg->labels], msg->labels_size - msg->labels))) {
+                return ret;
+            }
+            msg->type[msg->rrs]              = q.type;
+            msg->class[msg->rrs]             = q.class;
+            msg->ttl[msg->rrs]               = 0;
+            msg->rdlength[msg->rrs]          = 0;
+            msg->rdata_offset[msg->rrs]      = 0;
+            msg->label_count[msg->rrs]       = q.labels;
+            msg->rdata_label_count[msg->rrs] = 0;
+            msg->labels += q.labels;
+        } else {
+            if ((ret = core_object_dns_parse_rr(self, &rr, &msg->label[msg->labels], msg->labels_size - msg->labels))) {
+                return ret;
+            }
+            msg->type[msg->rrs]              = rr.type;
+            msg->class[msg->rrs]             = rr.class;
+            msg->ttl[msg->rrs]               = rr.ttl;
+            msg->rdlength[msg->rrs]          = rr.rdlength;
+            msg->rdata_offset[msg->rrs]      = rr.rdata_offset;
+            msg->label_count[msg->rrs]       = rr.labels;
+            msg->rdata_label_count[msg->rrs] = rr.rdata_labels;
+            msg->labels += rr.labels + rr.rdata_labels;
+        }
+
+        msg->rrs++;
+        (*parsed)++;
+    }
+
+    return 0;
+}
+
+int core_object_dns_parse_msg(core_object_dns_t* self, core_object_dns_msg_t* msg)
+{
+    int ret;
+    mlassert_self();
+    mlassert(msg, "msg is nil");
+
+    msg->rrs = msg->labels = 0;
+    msg->qdcount = msg->ancount = msg->nscount = msg->arcount = 0;
+    msg->error_rr = msg->error_offset = 0;
+
+    if ((ret = core_object_dns_parse_header(self))
+        || (ret = _parse_section(self, msg, CORE_OBJECT_DNS_SECTION_QUESTION, self->qdcount, &msg->qdcount))
+        || (ret = _parse_section(self, msg, CORE_OBJECT_DNS_SECTION_ANSWER, self->ancount, &msg->ancount))
+        || (ret = _parse_section(self, msg, CORE_OBJECT_DNS_SECTION_AUTHORITY, self->nscount, &msg->nscount))
+        || (ret = _parse_section(self, msg, CORE_OBJECT_DNS_SECTION_ADDITIONAL, self->arcount, &msg->arcount))) {
+        msg->error_rr     = msg->rrs;
+        msg->error_offset = self->at - self->payload;
+    }
+    msg->error = ret;
+
+    return ret;
+}
+
+/*
+ * Lowercase ASCII letters, length octets in a wire format name are never
+ * within A-Z so this can be done over the whole name.
+ */
+static inline void _lower(uint8_t* p, size_t len)
+{
+#ifdef __SSE2__
+    const __m128i a   = _mm_set1_epi8('A' - 1);
+    const __m128i z   = _mm_set1_epi8('Z' + 1);
+    const __m128i bit = _mm_set1_epi8(0x20);
+
+    for (; len >= 16; p += 16, len -= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i m = _mm_and_si128(_mm_cmpgt_epi8(v, a), _mm_cmplt_epi8(v, z));
+        _mm_storeu_si128((__m128i*)p, _mm_or_si128(v, _mm_and_si128(m, bit)));
+    }
+#endif
+    for (; len; p++, len--) {
+        if (*p >= 'A' && *p <= 'Z') {
+            *p |= 0x20;
+        }
+    }
+}
+
+int core_object_dns_name(const core_object_dns_t* self, size_t offset, int presentation, uint8_t* buf, size_t size)
+{
+    uint8_t        wire[255];
+    const uint8_t *msg, *end, *at;
+    size_t         n = 0, limit, i, j, k;
+    mlassert_self();
+    mlassert(buf, "buf is nil");
+
+    if (!self->payload) {
+        return _ERR_MALFORMED;
+    }
+    msg = self->payload;
+    end = self->payload + self->len;
+    if (self->includes_dnslen) {
+        msg += 2;
+    }
+    if (self->payload + offset < msg) {
+        return _ERR_MALFORMED;
+    }
+    at    = self->payload + offset;
+    limit = at - msg;
+
+    for (;;) {
+        if (at >= end) {
+            return _ERR_MALFORMED;
+        }
+        if ((*at & 0xc0) == 0xc0) {
+            if (at + 1 >= end) {
+                return _ERR_MALFORMED;
+            }
+            /* pointers must go backwards from the last, stops loops */
+            if ((i = ((at[0] & 0x3f) << 8) | at[1]) >= limit) {
+                return _ERR_MALFORMED;
+            }
+            limit = i;
+            at    = msg + i;
+            continue;
+        }
+        if (*at & 0xc0) {
+            return _ERR_MALFORMED;
+        }
+        if (!*at) {
+            wire[n++] = 0;
+            break;
+        }
+        if (n + 1 + *at >= sizeof(wire) || at + 1 + *at > end) {
+            return _ERR_MALFORMED;
+        }
+        memcpy(&wire[n], at, 1 + *at);
+        n += 1 + *at;
+        at += 1 + *at;
+    }
+
+    _lower(wire, n);
+
+    if (!presentation) {
+        if (n > size) {
+            return _ERR_NEEDSPACE;
+        }
+        memcpy(buf, wire, n);
+        return n;
+    }
+
+    if (n == 1) {
+        if (size < 1) {
+            return _ERR_NEEDSPACE;
+        }
+        buf[0] = '.';
+        return 1;
+    }
+    for (i = 0, j = 0; wire[i]; i += 1 + wire[i]) {
+        for (k = i + 1; k < i + 1 + wire[i]; k++) {
+            if (j + 5 > size) {
+                return _ERR_NEEDSPACE;
+            }
+            if (isalnum(wire[k]) || wire[k] == '-' || wire[k] == '_') {
+                buf[j++] = wire[k];
+            } else if (isprint(wire[k])) {
+                buf[j++] = '\\';
+                buf[j++] = wire[k];
+            } else {
+                buf[j++] = '\\';
+                buf[j++] = '0' + wire[k] / 100;
+                buf[j++] = '0' + (wire[k] / 10) % 10;
+                buf[j++] = '0' + wire[k] % 10;
+            }
+        }
+        if (j + 1 > size) {
+            return _ERR_NEEDSPACE;
+        }
+        buf[j++] = '.';
+    }
+
+    return j;
+}
+
+int core_object_dns_qname(const core_object_dns_t* self, int presentation, uint8_t* buf, size_t size)
+{
+    mlassert_self();
+
+    if (!self->qdcount) {
+        return _ERR_MALFORMED;
+    }
+    return core_object_dns_name(self, self->includes_dnslen ? 14 : 12, presentation, buf, size);
+}
+
+/*
+ * Message editing, the message is copied into the edit buffer where header
+ * fields are patched in place and insertions or removals only move the
+ * tail of the message after which compression pointers are adjusted.
+ */
+
+void core_object_dns_edit_init(core_object_dns_edit_t* edit, size_t size)
+{
+    static core_object_payload_t payload = CORE_OBJECT_PAYLOAD_INIT(0);
+    mlassert(edit, "edit is nil");
+
+    memset(edit, 0, sizeof(core_object_dns_edit_t));
+    edit->payload = payload;
+    edit->size    = size ? size : 65535;
+    mlfatal_oom(edit->buf = malloc(edit->size));
+    edit->payload.payload = edit->buf;
+}
+
+void core_object_dns_edit_destroy(core_object_dns_edit_t* edit)
+{
+    mlassert(edit, "edit is nil");
+    free(edit->buf);
+}
+
+static inline void _put16(uint8_t* p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xff;
+}
+
+/*
+ * Adjust compression pointers in the name at *at that points to from or
+ * after by delta, returns non-zero if malformed.
+ */
+static int _adjust_name(uint8_t* msg, size_t len, size_t* at, size_t from, int delta)
+{
+    size_t ptr;
+
+    while (*at < len) {
+        if ((msg[*at] & 0xc0) == 0xc0) {
+            if (*at + 2 > len) {
+                return 1;
+            }
+            ptr = ((msg[*at] & 0x3f) << 8) | msg[*at + 1];
+            if (ptr >= from) {
+                if ((delta < 0 && ptr < (size_t)-delta) || ptr + delta > 0x3fff) {
+                    return 1;
+                }
+                ptr += delta;
+                msg[*at]     = 0xc0 | (ptr >> 8);
+                msg[*at + 1] = ptr & 0xff;
+            }
+            *at += 2;
+            return 0;
+        }
+        if (msg[*at] & 0xc0) {
+            return 1;
+        }
+        if (!msg[*at]) {
+            *at += 1;
+            return 0;
+        }
+        *at += 1 + msg[*at];
+    }
+
+    return 1;
+}
+
+static int _adjust_rdata(uint8_t* msg, size_t at, size_t end, uint16_t type, size_t from, int delta)
+{
+    size_t names, n;
+
+    if (!(names = _rdata_labels(type))) {
+        return 0;
+    }
+
+    switch (type) {
+    case CORE_OBJECT_DNS_TYPE_MX:
+    case CORE_OBJECT_DNS_TYPE_AFSDB:
+    case CORE_OBJECT_DNS_TYPE_RT:
+    case CORE_OBJECT_DNS_TYPE_KX:
+    case CORE_OBJECT_DNS_TYPE_LP:
+    case CORE_OBJECT_DNS_TYPE_PX:
+        at += 2;
+        break;
+    case CORE_OBJECT_DNS_TYPE_SIG:
+    case CORE_OBJECT_DNS_TYPE_RRSIG:
+        at += 18;
+        break;
+    case CORE_OBJECT_DNS_TYPE_SRV:
+        at += 6;
+        break;
+    case CORE_OBJECT_DNS_TYPE_NAPTR:
+        at += 4;
+        for (n = 0; n < 3 && at < end; n++) {
+            at += 1 + msg[at];
+        }
+        break;
+    case CORE_OBJECT_DNS_TYPE_HIP:
+        if (at + 4 > end) {
+            return 1;
+        }
+        at += 4 + msg[at] + _need16(&msg[at + 2]);
+        names = 0;
+        while (at < end) {
+            if (_adjust_name(msg, end, &at, from, delta)) {
+                return 1;
+            }
+        }
+        break;
+    }
+
+    for (n = 0; n < names; n++) {
+        if (at >= end || _adjust_name(msg, end, &at, from, delta)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int _adjust(uint8_t* msg, size_t len, size_t from, int delta)
+{
+    size_t   at = 12, n, rrs, end;
+    uint16_t type;
+
+    for (n = _need16(&msg[4]); n; n--) {
+        if (_adjust_name(msg, len, &at, from, delta) || at + 4 > len) {
+            return 1;
+        }
+        at += 4;
+    }
+    rrs = (size_t)_need16(&msg[6]) + _need16(&msg[8]) + _need16(&msg[10]);
+    for (n = 0; n < rrs; n++) {
+        if (_adjust_name(msg, len, &at, from, delta) || at + 10 > len) {
+            return 1;
+        }
+        type = _need16(&msg[at]);
+        end  = at + 10 + _need16(&msg[at + 8]);
+        if (end > len || _adjust_rdata(msg, at + 10, end, type, from, delta)) {
+            return 1;
+        }
+        at = end;
+    }
+
+    return 0;
+}
+
+/*
+ * Find the OPT record, sets the offset of the start of it and the offset
+ * after it, returns non-zero if not found or malformed.
+ */
+static int _find_opt(const uint8_t* msg, size_t len, size_t* start, size_t* end)
+{
+    size_t   at = 12, n, an_ns, rrs;
+    uint16_t type;
+
+    for (n = _need16(&msg[4]); n; n--) {
+        if (_adjust_name((uint8_t*)msg, len, &at, 0x4000, 0) || at + 4 > len) {
+            return 1;
+        }
+        at += 4;
+    }
+    an_ns = (size_t)_need16(&msg[6]) + _need16(&msg[8]);
+    rrs   = an_ns + _need16(&msg[10]);
+    for (n = 0; n < rrs; n++) {
+        *start = at;
+        if (_adjust_name((uint8_t*)msg, len, &at, 0x4000, 0) || at + 10 > len) {
+            return 1;
+        }
+        type = _need16(&msg[at]);
+        at += 10 + _need16(&msg[at + 8]);
+        if (at > len) {
+            return 1;
+        }
+        if (type == CORE_OBJECT_DNS_TYPE_OPT && n >= an_ns) {
+            *end = at;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int core_object_dns_edit_load(core_object_dns_edit_t* edit, const core_object_dns_t* dns)
+{
+    const uint8_t* payload;
+    size_t         len;
+    mlassert(edit, "edit is nil");
+    mlassert(dns, "dns is nil");
+
+    if (!(payload = dns->payload)) {
+        return _ERR_MALFORMED;
+    }
+    len = dns->len;
+    if (dns->includes_dnslen) {
+        if (len < 2) {
+            return _ERR_MALFORMED;
+        }
+        payload += 2;
+        len -= 2;
+    }
+    if (len < 12) {
+        return _ERR_MALFORMED;
+    }
+    if (len > edit->size) {
+        return _ERR_NEEDSPACE;
+    }
+
+    memcpy(edit->buf, payload, len);
+    edit->payload.len     = len;
+    edit->payload.padding = 0;
+
+    return 0;
+}
+
+int core_object_dns_edit_id(core_object_dns_edit_t* edit, uint16_t id)
+{
+    mlassert(edit, "edit is nil");
+
+    if (edit->payload.len < 12) {
+        return _ERR_MALFORMED;
+    }
+    _put16(edit->buf, id);
+
+    return 0;
+}
+
+int core_object_dns_edit_flags(core_object_dns_edit_t* edit, uint16_t clear, uint16_t set)
+{
+    mlassert(edit, "edit is nil");
+
+    if (edit->payload.len < 12) {
+        return _ERR_MALFORMED;
+    }
+    _put16(&edit->buf[2], (_need16(&edit->buf[2]) & ~clear) | set);
+
+    return 0;
+}
+
+int core_object_dns_edit_strip_edns(core_object_dns_edit_t* edit)
+{
+    size_t start, end;
+    mlassert(edit, "edit is nil");
+
+    if (edit->payload.len < 12) {
+        return _ERR_MALFORMED;
+    }
+    if (_find_opt(edit->buf, edit->payload.len, &start, &end)) {
+        return 0;
+    }
+
+    memmove(&edit->buf[start], &edit->buf[end], edit->payload.len - end);
+    edit->payload.len -= end - start;
+    _put16(&edit->buf[10], _need16(&edit->buf[10]) - 1);
+
+    if (end < edit->payload.len + (end - start) && _adjust(edit->buf, edit->payload.len, end, -(int)(end - start))) {
+        return _ERR_MALFORMED;
+    }
+
+    return 0;
+}
+
+int core_object_dns_edit_add_edns(core_object_dns_edit_t* edit, uint16_t udp_size, int dnssec_ok)
+{
+    size_t   start, end;
+    uint8_t* at;
+    mlassert(edit, "edit is nil");
+
+    if (edit->payload.len < 12) {
+        return _ERR_MALFORMED;
+    }
+
+    if (!_find_opt(edit->buf, edit->payload.len, &start, &end)) {
+        /* OPT owner is the root name so the fixed part starts after it */
+        at = &edit->buf[start + 1];
+        _put16(&at[2], udp_size);
+        at[6] = dnssec_ok ? at[6] | 0x80 : at[6] & 0x7f;
+        return 0;
+    }
+
+    if (edit->payload.len + 11 > edit->size) {
+        return _ERR_NEEDSPACE;
+    }
+    at    = &edit->buf[edit->payload.len];
+    at[0] = 0;
+    _put16(&at[1], CORE_OBJECT_DNS_TYPE_OPT);
+    _put16(&at[3], udp_size);
+    at[5] = 0;
+    at[6] = 0;
+    at[7] = dnssec_ok ? 0x80 : 0;
+    at[8] = 0;
+    _put16(&at[9], 0);
+    edit->payload.len += 11;
+    _put16(&edit->buf[10], _need16(&edit->buf[10]) + 1);
+
+    return 0;
+}
+
+int core_object_dns_edit_qname_suffix(core_object_dns_edit_t* edit, const uint8_t* label, size_t len)
+{
+    size_t at = 12;
+    mlassert(edit, "edit is nil");
+    mlassert(label, "label is nil");
+
+    if (!len || len > 63) {
+        return _ERR_MALFORMED;
+    }
+    if (edit->payload.len < 12 || !_need16(&edit->buf[4])) {
+        return _ERR_MALFORMED;
+    }
+
+    /* find the end of the first question name */
+    while (at < edit->payload.len && edit->buf[at]) {
+        if (edit->buf[at] & 0xc0) {
+            return _ERR_MALFORMED;
+        }
+        at += 1 + edit->buf[at];
+    }
+    if (at >= edit->payload.len) {
+        return _ERR_MALFORMED;
+    }
+    if (at - 12 + 1 + len + 1 > 255) {
+        return _ERR_MALFORMED;
+    }
+    if (edit->payload.len + 1 + len > edit->size) {
+        return _ERR_NEEDSPACE;
+    }
+
+    memmove(&edit->buf[at + 1 + len], &edit->buf[at], edit->payload.len - at);
+    edit->buf[at] = len;
+    memcpy(&edit->buf[at + 1], label, len);
+    edit->payload.len += 1 + len;
+
+    if (_adjust(edit->buf, edit->payload.len, at, 1 + len)) {
+        return _ERR_MALFORMED;
+    }
+
+    return 0;
+}
+
 const char* core_object_dns_torfc1035(const char* str, size_t len)
 {
     mlassert(str, "str is nil");
@@ -20,6 +20,7 @@
 
 #include <dnsjit/core/log.h>
 #include <dnsjit/core/object.h>
+#include <dnsjit/core/object/payload.h>
 
 #ifndef __dnsjit_core_object_dns_h
 #define __dnsjit_core_object_dns_h
@@ -38,6 +39,11 @@
             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, \
     }
 
+#define CORE_OBJECT_DNS_SECTION_QUESTION 0
+#define CORE_OBJECT_DNS_SECTION_ANSWER 1
+#define CORE_OBJECT_DNS_SECTION_AUTHORITY 2
+#define CORE_OBJECT_DNS_SECTION_ADDITIONAL 3
+
 /*
  * 2016-12-09 https://www.iana.org/assignments/dns-parameters/dns-parameters.xhtml
  */
@@ -179,6 +185,7 @@
 #define CORE_OBJECT_DNS_EDNS0_OPT_TCP_KEEPALIVE 11
 #define CORE_OBJECT_DNS_EDNS0_OPT_PADDING 12
 #define CORE_OBJECT_DNS_EDNS0_OPT_CHAIN 13
+#define CORE_OBJECT_DNS_EDNS0_OPT_EDE 15
 #define CORE_OBJECT_DNS_EDNS0_OPT_DEVICEID 26946
 
 #endif
@@ -20,6 +20,7 @@
 
 // lua:require("dnsjit.core.log")
 // lua:require("dnsjit.core.object_h")
+// lua:require("dnsjit.core.object.payload_h")
 
 typedef struct core_object_dns_label {
     uint8_t is_end;
@@ -107,6 +108,64 @@ typedef struct core_object_dns {
     uint16_t arcount;
 } core_object_dns_t;
 
+typedef struct core_object_dns_msg {
+    size_t rrs_size, labels_size;
+
+    size_t   rrs, labels;
+    uint16_t qdcount, ancount, nscount, arcount;
+    int      error;
+    size_t   error_rr, error_offset;
+
+    size_t*                  rdata_offset;
+    size_t*                  first_label;
+    size_t*                  label_count;
+    size_t*                  rdata_label_count;
+    uint32_t*                ttl;
+    uint16_t*                type;
+    uint16_t*                class;
+    uint16_t*                rdlength;
+    uint8_t*                 section;
+    core_object_dns_label_t* label;
+} core_object_dns_msg_t;
+
+typedef struct core_object_dns_edns {
+    uint8_t have_opt;
+    uint8_t have_ecs;
+    uint8_t have_cookie;
+    uint8_t have_padding;
+    uint8_t have_ede;
+
+    uint16_t udp_size;
+    uint8_t  extended_rcode;
+    uint8_t  version;
+    uint8_t  dnssec_ok;
+    uint16_t flags;
+
+    size_t rdata_offset;
+    size_t rdlength;
+    size_t options;
+    size_t at;
+} core_object_dns_edns_t;
+
+typedef struct core_object_dns_edns_opt {
+    uint16_t       code;
+    uint16_t       len;
+    const uint8_t* data;
+
+    uint16_t ecs_family;
+    uint8_t  ecs_source_prefix;
+    uint8_t  ecs_scope_prefix;
+    uint8_t  ecs_address[16];
+
+    uint16_t ede_code;
+} core_object_dns_edns_opt_t;
+
+typedef struct core_object_dns_edit {
+    core_object_payload_t payload;
+    uint8_t*              buf;
+    size_t                size;
+} core_object_dns_edit_t;
+
 core_log_t* core_object_dns_log();
 
 core_object_dns_t* core_object_dns_new();
@@ -117,5 +176,23 @@ void               core_object_dns_reset(core_object_dns_t* self);
 int core_object_dns_parse_header(core_object_dns_t* self);
 int core_object_dns_parse_q(core_object_dns_t* self, core_object_dns_q_t* q, core_object_dns_label_t* label, size_t labels);
 int core_object_dns_parse_rr(core_object_dns_t* self, core_object_dns_rr_t* rr, core_object_dns_label_t* label, size_t labels);
+int core_object_dns_parse_msg(core_object_dns_t* self, core_object_dns_msg_t* msg);
+int core_object_dns_parse_edns(core_object_dns_t* self, core_object_dns_edns_t* edns);
+int core_object_dns_edns_next(const core_object_dns_t* self, core_object_dns_edns_t* edns, core_object_dns_edns_opt_t* opt);
+
+core_object_dns_msg_t* core_object_dns_msg_new(size_t rrs, size_t labels);
+void                   core_object_dns_msg_free(core_object_dns_msg_t* msg);
+
+int core_object_dns_name(const core_object_dns_t* self, size_t offset, int presentation, uint8_t* buf, size_t size);
+int core_object_dns_qname(const core_object_dns_t* self, int presentation, uint8_t* buf, size_t size);
+
+void core_object_dns_edit_init(core_object_dns_edit_t* edit, size_t size);
+void core_object_dns_edit_destroy(core_object_dns_edit_t* edit);
+int  core_object_dns_edit_load(core_object_dns_edit_t* edit, const core_object_dns_t* dns);
+int  core_object_dns_edit_id(core_object_dns_edit_t* edit, uint16_t id);
+int  core_object_dns_edit_flags(core_object_dns_edit_t* edit, uint16_t clear, uint16_t set);
+int  core_object_dns_edit_strip_edns(core_object_dns_edit_t* edit);
+int  core_object_dns_edit_add_edns(core_object_dns_edit_t* edit, uint16_t udp_size, int dnssec_ok);
+int  core_object_dns_edit_qname_suffix(core_object_dns_edit_t* edit, const uint8_t* label, size_t len);
 
 const char* core_object_dns_torfc1035(const char* str, size_t len);
@@ -39,6 +39,12 @@
 --       ...
 --     end
 --   end
+-- .SS Parse a DNS payload in one call
+--   local msg = require("dnsjit.core.object.dns.msg").new()
+--   local dns = require("dnsjit.core.object.dns").new(payload)
+--   if dns:parse_msg(msg) == 0 then
+--     ...
+--   end
 --
 -- The object that describes a DNS message.
 -- .SS Attributes
@@ -184,6 +190,7 @@ local C = ffi.C
 
 local t_name = "core_object_dns_t"
 local core_object_dns_t
+local _name = ffi.new("uint8_t[?]", 1024)
 local Dns = {
     CLASS = {
         IN = 1,
@@ -329,6 +336,7 @@ local Dns = {
         OPT_TCP_KEEPALIVE = 11,
         OPT_PADDING = 12,
         OPT_CHAIN = 13,
+        OPT_EDE = 15,
         OPT_DEVICEID = 26946,
     },
 }
@@ -470,6 +478,7 @@ _EDNS0[Dns.EDNS0.OPT_COOKIE] = "OPT_COOKIE"
 _EDNS0[Dns.EDNS0.OPT_TCP_KEEPALIVE] = "OPT_TCP_KEEPALIVE"
 _EDNS0[Dns.EDNS0.OPT_PADDING] = "OPT_PADDING"
 _EDNS0[Dns.EDNS0.OPT_CHAIN] = "OPT_CHAIN"
+_EDNS0[Dns.EDNS0.OPT_EDE] = "OPT_EDE"
 _EDNS0[Dns.EDNS0.OPT_DEVICEID] = "OPT_DEVICEID"
 Dns.CLASS_STR = _CLASS
 Dns.TYPE_STR = _TYPE
@@ -560,6 +569,69 @@ function Dns:parse_rr(rr, labels, num_labels)
     return C.core_object_dns_parse_rr(self, rr, labels, num_labels)
 end
 
+-- Parse the header, all questions and all resource records of the
+-- underlaying object in one call and store them in
+-- .IR msg ,
+-- a
+-- .BR dnsjit.core.object.dns.msg (3)
+-- object.
+-- Returns 0 on success or negative integer on error which can be for
+-- malformed or truncated DNS (-2), if more space for labels is needed (-3)
+-- or if more space for records is needed (-4).
+-- On error the records parsed so far are kept in
+-- .I msg
+-- along with the position of the error.
+function Dns:parse_msg(msg)
+    return C.core_object_dns_parse_msg(self, msg)
+end
+
+-- Parse the header and find the EDNS0 OPT record in the additional section
+-- of the underlaying object, without storing any other records, and fill in
+-- .IR edns ,
+-- a
+-- .BR dnsjit.core.object.dns.edns (3)
+-- object.
+-- Returns 0 on success, check
+-- .I have_opt
+-- to see if there was an OPT record, or negative integer on error which can
+-- be for malformed or truncated DNS (-2).
+function Dns:parse_edns(edns)
+    return C.core_object_dns_parse_edns(self, edns)
+end
+
+-- Return the domain name starting at
+-- .I offset
+-- within the payload, decompressed and in lowercase, or nil if it is
+-- malformed.
+-- The name is returned in presentation format (for example
+-- .IR www.example.com. )
+-- or in wire format if
+-- .I wire
+-- is true.
+-- Compression pointers are followed as long as they point before the
+-- previous one so loops are not possible.
+-- The header must have been parsed with
+-- .IR parse_header ()
+-- first.
+function Dns:name(offset, wire)
+    local len = C.core_object_dns_name(self, offset, wire == true and 0 or 1, _name, 1024)
+    if len < 0 then
+        return
+    end
+    return ffi.string(_name, len)
+end
+
+-- Return the name of the first question, nil if there is no question,
+-- see
+-- .IR name ().
+function Dns:qname(wire)
+    local len = C.core_object_dns_qname(self, wire == true and 0 or 1, _name, 1024)
+    if len < 0 then
+        return
+    end
+    return ffi.string(_name, len)
+end
+
 -- Begin parsing the underlaying object using
 -- .IR parse_header "(), "
 -- .IR parse_q ()
@@ -798,5 +870,8 @@ core_object_dns_t = ffi.metatype(t_name, { __index = Dns })
 -- dnsjit.core.object.payload (3),
 -- dnsjit.core.object.dns.label (3),
 -- dnsjit.core.object.dns.q (3),
--- dnsjit.core.object.dns.rr (3)
+-- dnsjit.core.object.dns.rr (3),
+-- dnsjit.core.object.dns.msg (3),
+-- dnsjit.core.object.dns.edns (3),
+-- dnsjit.core.object.dns.edit (3)
 return Dns
@@ -0,0 +1,133 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.core.object.dns.edit
+-- Edit a copy of a DNS message for replay
+--   local edit = require("dnsjit.core.object.dns.edit").new()
+--   if edit:load(dns) == 0 then
+--     edit:id(1234)
+--     edit:strip_edns()
+--     edit:qname_suffix("test")
+--     recv(ctx, edit.payload:uncast())
+--   end
+--
+-- An editor for DNS messages, typically queries that are going to be sent
+-- with
+-- .BR dnsjit.output.udpcli (3)
+-- or
+-- .BR dnsjit.output.dnscli (3).
+-- The message is copied once into a buffer preallocated by the editor,
+-- header fields are then patched in place and edits that change the length
+-- of the message only move the part of the message that follows the edit
+-- and adjust any compression pointers that pointed into it.
+-- .LP
+-- The edited message is available as the payload object
+-- .I edit.payload
+-- which is valid until the next
+-- .IR load ()
+-- and does not include the DNS length for TCP even if the original did.
+-- .LP
+-- All functions return 0 on success, -2 if the message is malformed and
+-- -5 if the edit does not fit into the buffer.
+-- .SS Attributes
+-- .TP
+-- payload
+-- The payload object of the edited message.
+-- .TP
+-- size
+-- The size of the buffer.
+module(...,package.seeall)
+
+require("dnsjit.core.object.dns_h")
+local ffi = require("ffi")
+local C = ffi.C
+
+local Edit = {}
+
+-- Create a new editor with a buffer of
+-- .I size
+-- bytes, default 65535.
+function Edit.new(size)
+    local self = ffi.new("core_object_dns_edit_t")
+    C.core_object_dns_edit_init(self, size or 65535)
+    return ffi.gc(self, C.core_object_dns_edit_destroy)
+end
+
+-- Copy the message of the
+-- .I dns
+-- object into the buffer, the object only needs to have had its header
+-- parsed.
+function Edit:load(dns)
+    return C.core_object_dns_edit_load(self, dns)
+end
+
+-- Set the ID of the message.
+function Edit:id(id)
+    return C.core_object_dns_edit_id(self, id)
+end
+
+-- Clear the bits in
+-- .I clear
+-- and then set the bits in
+-- .I set
+-- of the 16 bit flags following the ID (QR, opcode, AA, TC, RD, RA, Z, AD,
+-- CD and rcode).
+function Edit:flags(clear, set)
+    return C.core_object_dns_edit_flags(self, clear, set)
+end
+
+-- Set or clear the RD bit.
+function Edit:rd(bool)
+    if bool == true then
+        return C.core_object_dns_edit_flags(self, 0, 0x0100)
+    end
+    return C.core_object_dns_edit_flags(self, 0x0100, 0)
+end
+
+-- Remove the EDNS0 OPT record, if any, including all of its options.
+function Edit:strip_edns()
+    return C.core_object_dns_edit_strip_edns(self)
+end
+
+-- Add an EDNS0 OPT record with the UDP payload
+-- .I size
+-- and the DO bit set if
+-- .I dnssec_ok
+-- is true, if the message already has one then only the UDP payload size
+-- and DO bit of it are changed.
+function Edit:add_edns(size, dnssec_ok)
+    return C.core_object_dns_edit_add_edns(self, size, dnssec_ok == true and 1 or 0)
+end
+
+-- Append the
+-- .I label
+-- to the name of the first question, for example adding "test" to
+-- "example.com." gives "example.com.test.".
+-- Names in other parts of the message that point into the question name
+-- will also have the label appended so this is meant for queries.
+function Edit:qname_suffix(label)
+    return C.core_object_dns_edit_qname_suffix(self, label, #label)
+end
+
+ffi.metatype("core_object_dns_edit_t", { __index = Edit })
+
+-- dnsjit.core.object.dns (3),
+-- dnsjit.core.object.payload (3),
+-- dnsjit.output.udpcli (3),
+-- dnsjit.output.dnscli (3)
+return Edit
@@ -0,0 +1,153 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.core.object.dns.edns
+-- Container of a DNS EDNS0 OPT record
+--   local edns = require("dnsjit.core.object.dns.edns").new()
+--   if dns:parse_edns(edns) == 0 and edns.have_opt == 1 then
+--     print(edns.udp_size, edns.version, edns.dnssec_ok)
+--     for opt in edns:iterate(dns) do
+--       if opt.code == dns.EDNS0.OPT_CLIENT_SUBNET then
+--         print(opt:ecs_subnet())
+--       end
+--     end
+--   end
+--
+-- The object that describes the EDNS0 OPT record of a DNS message, filled
+-- in by
+-- .I parse_edns()
+-- in
+-- .BR dnsjit.core.object.dns (3).
+-- The options are read with
+-- .IR iterate ()
+-- which decodes Client Subnet (ECS) and Extended DNS Error (EDE) options,
+-- other options can be read from their data.
+-- .SS Attributes
+-- .TP
+-- have_opt
+-- Set if the message had an OPT record, the other attributes are only
+-- valid if this is set.
+-- .TP
+-- have_ecs, have_cookie, have_padding, have_ede
+-- Set if there is a Client Subnet, Cookie, Padding or Extended DNS Error
+-- option.
+-- .TP
+-- udp_size
+-- The requestor's UDP payload size.
+-- .TP
+-- extended_rcode
+-- The upper 8 bits of the extended response code.
+-- .TP
+-- version
+-- The EDNS version.
+-- .TP
+-- dnssec_ok
+-- Set if the DO bit is set.
+-- .TP
+-- flags
+-- All 16 bits of flags, including the DO bit.
+-- .TP
+-- rdata_offset
+-- The offset within the payload for the options.
+-- .TP
+-- rdlength
+-- The length of the options.
+-- .TP
+-- options
+-- The number of options.
+-- .SS Option attributes
+-- .TP
+-- code
+-- The option code.
+-- .TP
+-- len
+-- The length of the option data.
+-- .TP
+-- data
+-- A pointer to the option data within the payload, for a Cookie option the
+-- first 8 bytes are the client cookie followed by the server cookie if any.
+-- .TP
+-- ecs_family, ecs_source_prefix, ecs_scope_prefix
+-- For a Client Subnet option, the address family (1 for IPv4, 2 for IPv6),
+-- and source and scope prefix lengths.
+-- .TP
+-- ecs_address
+-- For a Client Subnet option, the address padded with zeros to 16 bytes.
+-- .TP
+-- ede_code
+-- For an Extended DNS Error option, the info code, any extra text follows
+-- it in the data.
+module(...,package.seeall)
+
+require("dnsjit.core.object.dns_h")
+local ffi = require("ffi")
+local C = ffi.C
+local libip = require("dnsjit.lib.ip")
+local OPT_CLIENT_SUBNET = require("dnsjit.core.object.dns").EDNS0.OPT_CLIENT_SUBNET
+
+local Edns = {}
+local Opt = {}
+
+-- Create a new EDNS0 container.
+function Edns.new()
+    return ffi.new("core_object_dns_edns_t")
+end
+
+-- Create a new EDNS0 option.
+function Edns.opt()
+    return ffi.new("core_object_dns_edns_opt_t")
+end
+
+-- Return an iterator over the options of the OPT record in
+-- .IR dns ,
+-- the same option object is returned on each iteration unless
+-- .I opt
+-- is given in which case that is used.
+-- Iteration stops at the end or on a malformed option.
+function Edns:iterate(dns, opt)
+    if opt == nil then
+        opt = Edns.opt()
+    end
+    self.at = self.rdata_offset
+    return function()
+        if C.core_object_dns_edns_next(dns, self, opt) == 0 then
+            return opt
+        end
+    end
+end
+
+-- Return the Client Subnet of the option as a string in the form
+-- .IR address/prefix ,
+-- or nil if not a Client Subnet option.
+function Opt:ecs_subnet()
+    if self.code ~= OPT_CLIENT_SUBNET then
+        return
+    end
+    if self.ecs_family == 1 then
+        return libip.ipstring(self.ecs_address) .. "/" .. self.ecs_source_prefix
+    elseif self.ecs_family == 2 then
+        return libip.ip6string(self.ecs_address, true) .. "/" .. self.ecs_source_prefix
+    end
+end
+
+ffi.metatype("core_object_dns_edns_t", { __index = Edns })
+ffi.metatype("core_object_dns_edns_opt_t", { __index = Opt })
+
+-- dnsjit.core.object.dns (3),
+-- dnsjit.lib.ip (3)
+return Edns
@@ -0,0 +1,136 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.core.object.dns.msg
+-- Container of a fully parsed DNS message
+--   local msg = require("dnsjit.core.object.dns.msg").new()
+--   if dns:parse_msg(msg) == 0 then
+--     for n = 0, tonumber(msg.rrs) - 1 do
+--       print(msg.section[n], msg.type[n], msg.class[n], msg.ttl[n])
+--     end
+--   end
+--
+-- The object that holds all questions and resource records of a DNS message
+-- parsed in one call with
+-- .I parse_msg()
+-- in
+-- .BR dnsjit.core.object.dns (3).
+-- Records are stored as arrays indexed by record, starting at zero, with the
+-- questions first followed by the answers, authorities and additionals.
+-- The object is reused for each message parsed.
+-- .SS Attributes
+-- .TP
+-- rrs_size
+-- The number of records that can be stored.
+-- .TP
+-- labels_size
+-- The number of labels that can be stored.
+-- .TP
+-- rrs
+-- The number of records parsed.
+-- .TP
+-- labels
+-- The number of labels used.
+-- .TP
+-- qdcount, ancount, nscount, arcount
+-- The number of records parsed for each section.
+-- .TP
+-- error
+-- The result code of the parsing, see
+-- .I parse_msg()
+-- in
+-- .BR dnsjit.core.object.dns (3).
+-- .TP
+-- error_rr
+-- The index of the record where parsing failed.
+-- .TP
+-- error_offset
+-- The offset within the payload where parsing stopped on failure.
+-- .TP
+-- section
+-- The section of each record, see
+-- .IR QUESTION ", " ANSWER ", " AUTHORITY " and " ADDITIONAL .
+-- .TP
+-- type, class, ttl, rdlength
+-- The type, class, TTL and resource record data length of each record,
+-- TTL and data length are zero for questions.
+-- .TP
+-- rdata_offset
+-- The offset within the payload for the resource record data of each record.
+-- .TP
+-- first_label
+-- The index into
+-- .I label
+-- of the first label of each record.
+-- .TP
+-- label_count
+-- The number of labels of the record name.
+-- .TP
+-- rdata_label_count
+-- The number of labels inside the resource record data, these follows
+-- the labels of the record name.
+-- .TP
+-- label
+-- The array of labels, see
+-- .BR dnsjit.core.object.dns.label (3).
+module(...,package.seeall)
+
+require("dnsjit.core.object.dns_h")
+local ffi = require("ffi")
+local C = ffi.C
+local label = require("dnsjit.core.object.dns.label")
+
+local t_name = "core_object_dns_msg_t"
+local core_object_dns_msg_t
+local Msg = {
+    QUESTION = 0,
+    ANSWER = 1,
+    AUTHORITY = 2,
+    ADDITIONAL = 3,
+}
+
+-- Create a new message container that can store
+-- .I rrs
+-- records (default 64) and
+-- .I labels
+-- labels (default 512).
+function Msg.new(rrs, labels)
+    if rrs == nil then
+        rrs = 64
+    end
+    if labels == nil then
+        labels = 512
+    end
+    return ffi.gc(C.core_object_dns_msg_new(rrs, labels), C.core_object_dns_msg_free)
+end
+
+-- Return the name of record
+-- .I n
+-- as a string, see
+-- .I tostring()
+-- in
+-- .BR dnsjit.core.object.dns.label (3).
+function Msg:name(dns, n)
+    return label.tostring(dns, self.label, self.label_count[n], self.first_label[n])
+end
+
+core_object_dns_msg_t = ffi.metatype(t_name, { __index = Msg })
+
+-- dnsjit.core.object.dns (3),
+-- dnsjit.core.object.dns.label (3)
+return Msg
@@ -30,7 +30,7 @@ typedef struct core_object_gre {
     uint16_t offset;
     uint32_t key;
     uint32_t sequence;
-    // TODO: routing list, check RFC 1701.
+    // Source Route Entries (RFC 1701) are skipped.
 } core_object_gre_t;
 
 core_object_gre_t* core_object_gre_copy(const core_object_gre_t* self);
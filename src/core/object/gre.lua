@@ -21,7 +21,9 @@
 --
 -- The GRE part of a packet that usually can be found in the object chain
 -- after parsing with, for example, Layer filter.
--- See RFC 1701.
+-- See RFC 1701, RFC 2784 and RFC 2890.
+-- Optional fields not present in the header are zero and the routing
+-- information (Source Route Entries) is skipped.
 -- .SS Attributes
 -- .TP
 -- gre_flags
@@ -33,6 +35,10 @@
 -- checksum
 -- The checksum of the GRE header and the payload packet.
 -- .TP
+-- offset
+-- The offset from the start of the routing field to the first octet of the
+-- active Source Route Entry.
+-- .TP
 -- key
 -- The Key field contains a four octet number which was inserted by
 -- the encapsulator.
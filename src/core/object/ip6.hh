@@ -34,7 +34,7 @@ typedef struct core_object_ip6 {
     uint8_t  is_frag;
     uint8_t  have_rtdst;
     uint16_t frag_offlg;
-    uint16_t frag_ident;
+    uint32_t frag_ident;
     uint8_t  rtdst[16];
 
     uint16_t hlen;
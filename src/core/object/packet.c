@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "core/object/packet.h"
+#include "core/assert.h"
+#include "core/pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+core_object_packet_t* core_object_packet_copy(const core_object_packet_t* self)
+{
+    core_object_packet_t* copy;
+    glassert_self();
+
+    glfatal_oom(copy = core_pool_alloc(0, sizeof(core_object_packet_t)));
+    memcpy(copy, self, sizeof(core_object_packet_t));
+    copy->obj_prev = 0;
+
+    /* the objects referenced are not part of the copy */
+    copy->pcap      = 0;
+    copy->link      = 0;
+    copy->ip        = 0;
+    copy->transport = 0;
+    copy->payload   = 0;
+
+    return copy;
+}
+
+void core_object_packet_free(core_object_packet_t* self)
+{
+    glassert_self();
+    core_pool_free(self);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// lua:require("dnsjit.core.object_h")
+// lua:require("dnsjit.core.timespec_h")
+// lua:require("dnsjit.core.object.pcap_h")
+// lua:require("dnsjit.core.object.payload_h")
+
+typedef struct core_object_packet {
+    const core_object_t* obj_prev;
+    int32_t              obj_type;
+
+    const core_object_pcap_t*    pcap;
+    const core_object_t*         link;
+    const core_object_t*         ip;
+    const core_object_t*         transport;
+    const core_object_payload_t* payload;
+
+    size_t l3_offset, l4_offset, payload_offset, len;
+
+    core_timespec_t ts;
+
+    uint8_t  ip_version, proto;
+    uint16_t sport, dport;
+    uint8_t  src[16];
+    uint8_t  dst[16];
+} core_object_packet_t;
+
+core_object_packet_t* core_object_packet_copy(const core_object_packet_t* self);
+void                  core_object_packet_free(core_object_packet_t* self);
@@ -0,0 +1,149 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.core.object.packet
+-- A packet context
+--
+-- A flat summary of a parsed packet, filled in once per packet by
+-- .I dnsjit.filter.layer
+-- when enabled with
+-- .IR context ().
+-- It is placed at the top of the object chain and gives direct access to
+-- the layers, offsets and addresses of the packet without walking the chain.
+-- For a tunneled packet all attributes describe the innermost packet,
+-- the one closest to the payload.
+-- .SS Attributes
+-- .TP
+-- pcap
+-- The packet object the context was made from.
+-- .TP
+-- link
+-- The link layer object, nil if none.
+-- .TP
+-- ip
+-- The IP or IPv6 object, nil if none.
+-- .TP
+-- transport
+-- The UDP, TCP, ICMP, ICMPv6 or GRE object, nil if none.
+-- .TP
+-- payload
+-- The payload object, nil if none.
+-- .TP
+-- l3_offset
+-- Offset of the IP header within the packet bytes.
+-- .TP
+-- l4_offset
+-- Offset of the transport header within the packet bytes.
+-- .TP
+-- payload_offset
+-- Offset of the payload within the packet bytes.
+-- .TP
+-- len
+-- The length of the payload.
+-- .TP
+-- ts
+-- Timestamp of the packet.
+-- .TP
+-- ip_version
+-- The IP version, 4 or 6, or 0 if there was no IP layer.
+-- .TP
+-- proto
+-- The IP protocol of the transport.
+-- .TP
+-- sport
+-- Source port.
+-- .TP
+-- dport
+-- Destination port.
+-- .TP
+-- src
+-- Source address, the first 4 bytes for IPv4.
+-- .TP
+-- dst
+-- Destination address, the first 4 bytes for IPv4.
+-- .LP
+-- Offsets are zero if the layer is missing.
+-- A copy of the object does not reference any other objects unless they
+-- were copied together using
+-- .IR copy_chain ()
+-- in
+-- .BR dnsjit.core.object (3).
+module(...,package.seeall)
+
+require("dnsjit.core.object.packet_h")
+local ffi = require("ffi")
+local C = ffi.C
+local libip = require("dnsjit.lib.ip")
+
+local t_name = "core_object_packet_t"
+local core_object_packet_t
+local Packet = {}
+
+-- Return the textual type of the object.
+function Packet:type()
+    return "packet"
+end
+
+-- Return the previous object.
+function Packet:prev()
+    return self.obj_prev
+end
+
+-- Cast the object to the underlining object module and return it.
+function Packet:cast()
+    return self
+end
+
+-- Cast the object to the generic object module and return it.
+function Packet:uncast()
+    return ffi.cast("core_object_t*", self)
+end
+
+-- Make a copy of the object and return it.
+function Packet:copy()
+    return C.core_object_packet_copy(self)
+end
+
+-- Free the object, should only be used on copies or otherwise allocated.
+function Packet:free()
+    C.core_object_packet_free(self)
+end
+
+-- Return the IP source as a string, or nil if there was no IP layer.
+function Packet:source()
+    if self.ip_version == 4 then
+        return libip.ipstring(self.src)
+    elseif self.ip_version == 6 then
+        return libip.ip6string(self.src)
+    end
+end
+
+-- Return the IP destination as a string, or nil if there was no IP layer.
+function Packet:destination()
+    if self.ip_version == 4 then
+        return libip.ipstring(self.dst)
+    elseif self.ip_version == 6 then
+        return libip.ip6string(self.dst)
+    end
+end
+
+core_object_packet_t = ffi.metatype(t_name, { __index = Packet })
+
+-- dnsjit.core.object (3),
+-- dnsjit.filter.layer (3)
+return Packet
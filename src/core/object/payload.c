@@ -22,6 +22,7 @@
 
 #include "core/object/payload.h"
 #include "core/assert.h"
+#include "core/pool.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -31,7 +32,7 @@ core_object_payload_t* core_object_payload_copy(const core_object_payload_t* sel
     core_object_payload_t* copy;
     glassert_self();
 
-    glfatal_oom(copy = malloc(sizeof(core_object_payload_t) + self->len + self->padding));
+    glfatal_oom(copy = core_pool_alloc(0, sizeof(core_object_payload_t) + self->len + self->padding));
     memcpy(copy, self, sizeof(core_object_payload_t));
     copy->obj_prev = 0;
 
@@ -46,5 +47,5 @@ core_object_payload_t* core_object_payload_copy(const core_object_payload_t* sel
 void core_object_payload_free(core_object_payload_t* self)
 {
     glassert_self();
-    free(self);
+    core_pool_free(self);
 }
@@ -22,6 +22,7 @@
 
 #include "core/object/udp.h"
 #include "core/assert.h"
+#include "core/pool.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -31,7 +32,7 @@ core_object_udp_t* core_object_udp_copy(const core_object_udp_t* self)
     core_object_udp_t* copy;
     glassert_self();
 
-    glfatal_oom(copy = malloc(sizeof(core_object_udp_t)));
+    glfatal_oom(copy = core_pool_alloc(0, sizeof(core_object_udp_t)));
     memcpy(copy, self, sizeof(core_object_udp_t));
     copy->obj_prev = 0;
 
@@ -41,5 +42,5 @@ core_object_udp_t* core_object_udp_copy(const core_object_udp_t* self)
 void core_object_udp_free(core_object_udp_t* self)
 {
     glassert_self();
-    free(self);
+    core_pool_free(self);
 }
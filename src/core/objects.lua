@@ -42,6 +42,7 @@ require("dnsjit.core.object.udp")
 require("dnsjit.core.object.tcp")
 require("dnsjit.core.object.payload")
 require("dnsjit.core.object.dns")
+require("dnsjit.core.object.packet")
 
 -- dnsjit.core.object (3),
 -- dnsjit.core.object.pcap (3),
@@ -59,5 +60,6 @@ require("dnsjit.core.object.dns")
 -- dnsjit.core.object.udp (3),
 -- dnsjit.core.object.tcp (3),
 -- dnsjit.core.object.payload (3),
--- dnsjit.core.object.dns (3)
+-- dnsjit.core.object.dns (3),
+-- dnsjit.core.object.packet (3)
 return object
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "core/poller.h"
+#include "core/assert.h"
+
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+static core_log_t    _log      = LOG_T_INIT("core.poller");
+static core_poller_t _defaults = {
+    LOG_T_INIT_OBJ("core.poller"),
+    -1, 0, 0, 0
+};
+
+core_log_t* core_poller_log()
+{
+    return &_log;
+}
+
+void core_poller_init(core_poller_t* self)
+{
+    mlassert_self();
+
+    *self = _defaults;
+}
+
+void core_poller_destroy(core_poller_t* self)
+{
+    mlassert_self();
+
+    if (self->epfd > -1) {
+        close(self->epfd);
+    }
+    free(self->entries);
+    free(self->events);
+}
+
+static int _add(core_poller_t* self, core_channel_t* chan, int fd)
+{
+    core_poller_entry_t* entries;
+    int                  idx = self->entries_len;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev;
+
+    if (self->epfd < 0 && (self->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        lcritical("epoll_create1() error: %s", core_log_errstr(errno));
+        self->epfd = -1;
+        return -1;
+    }
+
+    ev.events   = EPOLLIN;
+    ev.data.u64 = idx;
+    if (epoll_ctl(self->epfd, EPOLL_CTL_ADD, fd, &ev)) {
+        lcritical("epoll_ctl() error: %s", core_log_errstr(errno));
+        return -1;
+    }
+    free(self->events);
+    lfatal_oom(self->events = malloc(sizeof(struct epoll_event) * (self->entries_len + 1)));
+#else
+    free(self->events);
+    lfatal_oom(self->events = malloc(sizeof(struct pollfd) * (self->entries_len + 1)));
+#endif
+
+    lfatal_oom(entries = realloc(self->entries, sizeof(core_poller_entry_t) * (self->entries_len + 1)));
+    entries[idx].chan  = chan;
+    entries[idx].fd    = fd;
+    entries[idx].ready = 0;
+    self->entries      = entries;
+    self->entries_len++;
+
+    return idx;
+}
+
+int core_poller_add_channel(core_poller_t* self, core_channel_t* chan)
+{
+    int fd;
+    mlassert_self();
+    lassert(chan, "chan is nil");
+
+    if ((fd = core_channel_notify(chan)) < 0) {
+        return -1;
+    }
+    return _add(self, chan, fd);
+}
+
+int core_poller_add_fd(core_poller_t* self, int fd)
+{
+    mlassert_self();
+
+    if (fd < 0) {
+        lwarning("invalid fd %d", fd);
+        return -1;
+    }
+    return _add(self, 0, fd);
+}
+
+static inline void _set_ready(core_poller_entry_t* entry, int* ready)
+{
+    if (entry->chan) {
+        core_channel_notify_clear(entry->chan);
+    }
+    if (!entry->ready) {
+        entry->ready = 1;
+        (*ready)++;
+    }
+}
+
+int core_poller_wait(core_poller_t* self, int timeout)
+{
+    size_t i;
+    int    n, ready = 0;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event* events = (struct epoll_event*)self->events;
+#else
+    struct pollfd* events = (struct pollfd*)self->events;
+#endif
+    mlassert_self();
+
+    if (!self->entries_len) {
+        return 0;
+    }
+
+    /*
+     * Arm the notification of all channels, if any already has objects
+     * then we only check the file descriptors without waiting.
+     */
+    for (i = 0; i < self->entries_len; i++) {
+        core_poller_entry_t* entry = &self->entries[i];
+
+        entry->ready = 0;
+        if (entry->chan && core_channel_notify_arm(entry->chan)) {
+            entry->ready = 1;
+            ready++;
+        }
+    }
+    if (ready) {
+        timeout = 0;
+    }
+
+#ifdef HAVE_SYS_EPOLL_H
+    if ((n = epoll_wait(self->epfd, events, self->entries_len, timeout)) < 0) {
+        if (errno == EINTR) {
+            return ready;
+        }
+        lcritical("epoll_wait() error: %s", core_log_errstr(errno));
+        return -1;
+    }
+    for (i = 0; i < (size_t)n; i++) {
+        _set_ready(&self->entries[events[i].data.u64], &ready);
+    }
+#else
+    for (i = 0; i < self->entries_len; i++) {
+        events[i].fd      = self->entries[i].fd;
+        events[i].events  = POLLIN;
+        events[i].revents = 0;
+    }
+    if ((n = poll(events, self->entries_len, timeout)) < 0) {
+        if (errno == EINTR) {
+            return ready;
+        }
+        lcritical("poll() error: %s", core_log_errstr(errno));
+        return -1;
+    }
+    for (i = 0; n && i < self->entries_len; i++) {
+        if (events[i].revents) {
+            _set_ready(&self->entries[i], &ready);
+            n--;
+        }
+    }
+#endif
+
+    return ready;
+}
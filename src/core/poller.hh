@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// lua:require("dnsjit.core.log")
+// lua:require("dnsjit.core.channel_h")
+
+typedef struct core_poller_entry {
+    core_channel_t* chan;
+    int             fd;
+    int             ready;
+} core_poller_entry_t;
+
+typedef struct core_poller {
+    core_log_t           _log;
+    int                  epfd;
+    core_poller_entry_t* entries;
+    size_t               entries_len;
+    void*                events;
+} core_poller_t;
+
+core_log_t* core_poller_log();
+
+void core_poller_init(core_poller_t* self);
+void core_poller_destroy(core_poller_t* self);
+int  core_poller_add_channel(core_poller_t* self, core_channel_t* chan);
+int  core_poller_add_fd(core_poller_t* self, int fd);
+int  core_poller_wait(core_poller_t* self, int timeout);
@@ -0,0 +1,131 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.core.poller
+-- Wait for multiple channels and file descriptors at once
+--   local poller = require("dnsjit.core.poller").new()
+--   poller:add(chan1)
+--   poller:add(chan2)
+--   poller:add(dnscli)
+--   while true do
+--       for _, o in pairs(poller:wait(1000)) do
+--           if o == chan1 then
+--               local obj = chan1:try_get()
+--               ...
+--           elseif o == dnscli then
+--               dnscli:produce()
+--               ...
+--           end
+--       end
+--   end
+--
+-- A poller lets a thread sleep until any of a number of channels has
+-- objects or any of a number of file descriptors becomes readable,
+-- instead of busy-looping over
+-- .IR try_get ()
+-- and
+-- .IR produce ().
+-- It uses
+-- .IR epoll (7)
+-- if available, otherwise
+-- .IR poll (2).
+-- .LP
+-- Channels added to a poller get a notification handle (see
+-- .BR dnsjit.core.channel (3)),
+-- this should be done before the channel is used by other threads.
+-- The poller itself should only be used by one thread.
+module(...,package.seeall)
+
+require("dnsjit.core.poller_h")
+local ffi = require("ffi")
+local C = ffi.C
+
+local t_name = "core_poller_t"
+local core_poller_t = ffi.typeof(t_name)
+local Poller = {}
+
+-- Create a new Poller.
+function Poller.new()
+    local self = {
+        objs = {},
+        obj = core_poller_t(),
+    }
+    C.core_poller_init(self.obj)
+    ffi.gc(self.obj, C.core_poller_destroy)
+    return setmetatable(self, { __index = Poller })
+end
+
+-- Return the Log object to control logging of this instance or module.
+function Poller:log()
+    if self == nil then
+        return C.core_poller_log()
+    end
+    return self.obj._log
+end
+
+-- Add a channel, a file descriptor (number) or a module with a file
+-- descriptor (such as
+-- .IR output.dnscli )
+-- to the poller, file descriptors are polled for readability.
+-- Returns true on success or nil if it could not be added, such as for an
+-- invalid file descriptor or a module without one.
+function Poller:add(o)
+    local idx
+    if ffi.istype("core_channel_t", o) or ffi.istype("core_channel_t*", o) then
+        idx = C.core_poller_add_channel(self.obj, o)
+    elseif type(o) == "number" then
+        idx = C.core_poller_add_fd(self.obj, o)
+    elseif type(o) == "table" and o.obj and o.obj.fd then
+        idx = C.core_poller_add_fd(self.obj, o.obj.fd)
+    else
+        return
+    end
+    if idx < 0 then
+        return
+    end
+    self.objs[idx + 1] = o
+    return true
+end
+
+-- Wait for any of the added channels or file descriptors to become ready,
+-- for at most
+-- .I timeout
+-- milliseconds (default -1 which waits forever).
+-- Returns a table with the ready channels, file descriptors and modules,
+-- the table is empty on timeout or nil on error.
+function Poller:wait(timeout)
+    if timeout == nil then
+        timeout = -1
+    end
+    local n = C.core_poller_wait(self.obj, timeout)
+    if n < 0 then
+        return
+    end
+    local ready = {}
+    if n > 0 then
+        for i = 0, tonumber(self.obj.entries_len) - 1 do
+            if self.obj.entries[i].ready == 1 then
+                table.insert(ready, self.objs[i + 1])
+            end
+        end
+    end
+    return ready
+end
+
+-- dnsjit.core.channel (3)
+return Poller
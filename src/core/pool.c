@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "core/pool.h"
+#include "core/assert.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <ck_pr.h>
+
+#define N_CLASSES (sizeof(((core_pool_t*)0)->classes) / sizeof(core_pool_class_t))
+#define MIN_SHIFT 6
+
+/*
+ * Every block handed out has a small header in front of it so that
+ * core_pool_free() can find its way back without knowing the pool, blocks
+ * too large for any class (or allocated without a pool) are plain heap
+ * allocations with a nil pool in the header.
+ * The header also holds the reference count used by core_pool_retain() and
+ * core_pool_release(), and a magic value so that these can tell a block
+ * from memory not allocated here.
+ */
+typedef struct _block {
+    core_pool_t* pool;
+    uint16_t     magic;
+    uint16_t     cls;
+    uint32_t     refs;
+} _block_t;
+
+#define BLOCK_MAGIC 0xb10c
+
+typedef struct _slab {
+    struct _slab* next;
+    size_t        _pad;
+} _slab_t;
+
+static core_log_t  _log      = LOG_T_INIT("core.pool");
+static core_pool_t _defaults = {
+    LOG_T_INIT_OBJ("core.pool"),
+    65536, 0,
+    0, 0, 0
+};
+
+core_log_t* core_pool_log()
+{
+    return &_log;
+}
+
+void core_pool_init(core_pool_t* self, size_t slab_size)
+{
+    size_t n;
+    mlassert_self();
+
+    *self = _defaults;
+    if (slab_size) {
+        self->slab_size = slab_size;
+    }
+    for (n = 0; n < N_CLASSES; n++) {
+        self->classes[n].size = (size_t)1 << (MIN_SHIFT + n);
+    }
+}
+
+void core_pool_destroy(core_pool_t* self)
+{
+    _slab_t* slab;
+    mlassert_self();
+
+    while ((slab = self->slabs)) {
+        self->slabs = slab->next;
+        free(slab);
+    }
+}
+
+static inline size_t _class(size_t size)
+{
+    if (size <= ((size_t)1 << MIN_SHIFT)) {
+        return 0;
+    }
+    return (sizeof(unsigned long long) * 8 - __builtin_clzll(size - 1)) - MIN_SHIFT;
+}
+
+static int _refill(core_pool_t* self, size_t cls)
+{
+    core_pool_class_t* c = &self->classes[cls];
+    _slab_t*           slab;
+    _block_t*          b;
+    size_t             n = self->slab_size / c->size;
+
+    if (!n) {
+        n = 1;
+    }
+    if (!(slab = malloc(sizeof(_slab_t) + n * c->size))) {
+        return -1;
+    }
+    slab->next  = self->slabs;
+    self->slabs = slab;
+    self->slabs_allocated++;
+
+    b = (_block_t*)((uint8_t*)slab + sizeof(_slab_t) + (n - 1) * c->size);
+    while (n--) {
+        b->pool          = self;
+        b->magic         = BLOCK_MAGIC;
+        b->cls           = cls;
+        *(void**)(b + 1) = c->local;
+        c->local         = b;
+        b                = (_block_t*)((uint8_t*)b - c->size);
+    }
+
+    return 0;
+}
+
+void* core_pool_alloc(core_pool_t* self, size_t size)
+{
+    core_pool_class_t* c;
+    _block_t*          b;
+    size_t             cls;
+
+    if (self && (cls = _class(size + sizeof(_block_t))) < N_CLASSES) {
+        c = &self->classes[cls];
+        if (!c->local) {
+            // take everything other threads have given back in one go
+            c->local = ck_pr_fas_ptr(&c->remote, 0);
+            ck_pr_fence_load();
+            if (!c->local && _refill(self, cls)) {
+                return 0;
+            }
+        }
+        b        = c->local;
+        c->local = *(void**)(b + 1);
+        b->refs  = 1;
+        self->allocs++;
+        return b + 1;
+    }
+
+    if (!(b = malloc(sizeof(_block_t) + size))) {
+        return 0;
+    }
+    b->pool  = 0;
+    b->magic = BLOCK_MAGIC;
+    b->cls   = 0;
+    b->refs  = 1;
+    if (self) {
+        self->oversized++;
+    }
+    return b + 1;
+}
+
+void core_pool_free(void* ptr)
+{
+    _block_t*          b = (_block_t*)ptr - 1;
+    core_pool_class_t* c;
+    void*              head;
+
+    if (!ptr) {
+        return;
+    }
+    if (!b->pool) {
+        free(b);
+        return;
+    }
+
+    c = &b->pool->classes[b->cls];
+    do {
+        head         = ck_pr_load_ptr(&c->remote);
+        *(void**)ptr = head;
+        ck_pr_fence_store();
+    } while (!ck_pr_cas_ptr(&c->remote, head, b));
+}
+
+static inline _block_t* _block(void* ptr)
+{
+    _block_t* b = (_block_t*)ptr - 1;
+
+    if (b->magic != BLOCK_MAGIC) {
+        glfatal("%p was not allocated by core.pool", ptr);
+    }
+    return b;
+}
+
+void core_pool_retain(void* ptr)
+{
+    ck_pr_inc_32(&_block(ptr)->refs);
+}
+
+int core_pool_release(void* ptr)
+{
+    bool zero;
+
+    ck_pr_dec_32_zero(&_block(ptr)->refs, &zero);
+    return zero;
+}
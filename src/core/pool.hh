@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// lua:require("dnsjit.core.log")
+
+typedef struct core_pool_class {
+    void*   local;
+    size_t  size;
+    uint8_t _pad1[48];
+    void*   remote;
+    uint8_t _pad2[56];
+} core_pool_class_t;
+
+typedef struct core_pool {
+    core_log_t _log;
+    size_t     slab_size;
+    void*      slabs;
+
+    uint64_t allocs, slabs_allocated, oversized;
+
+    core_pool_class_t classes[12];
+} core_pool_t;
+
+core_log_t* core_pool_log();
+
+void  core_pool_init(core_pool_t* self, size_t slab_size);
+void  core_pool_destroy(core_pool_t* self);
+void* core_pool_alloc(core_pool_t* self, size_t size);
+void  core_pool_free(void* ptr);
+void  core_pool_retain(void* ptr);
+int   core_pool_release(void* ptr);
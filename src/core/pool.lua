@@ -0,0 +1,102 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.core.pool
+-- Slab allocator for object copies
+--   local pool = require("dnsjit.core.pool").new()
+--   local copy = require("dnsjit.filter.copy").new()
+--   copy:obj_type(object.PAYLOAD)
+--   copy:pool(pool)
+--   copy:receiver(chan)
+--
+-- A pool keeps freed memory in per size class free lists carved from large
+-- slabs instead of going to the general heap for each object copy, which
+-- avoids contention on the heap when copies made in one thread are freed
+-- in another.
+-- Each object type has a fixed size so in practice every type (and pcap or
+-- payload objects of similar size) gets a free list of its own.
+-- .LP
+-- Pooled copies are freed as any other copy, with
+-- .IR free ()
+-- on the object or
+-- .IR core_object_free ()
+-- in C, and the memory is returned to the pool it came from.
+-- .SS Threads
+-- Memory may only be taken from a pool by one thread at a time, normally
+-- the thread running the filter that copies objects, while pooled objects
+-- can be freed from any thread.
+-- Using one pool per pipeline keeps both sides of a channel hand-off on
+-- memory that no other pipeline touches.
+-- .SS Lifetime
+-- Memory held by the pool, including objects still in use, is released
+-- when the pool is destroyed so the pool must outlive all copies made
+-- from it.
+-- Copies too large for the biggest size class (128 KiB) are allocated from
+-- the heap and do not depend on the pool.
+-- .SS Attributes
+-- .TP
+-- slab_size
+-- Size in bytes of each slab, default 65536.
+-- .TP
+-- allocs
+-- Number of allocations served by the pool.
+-- .TP
+-- slabs_allocated
+-- Number of slabs allocated.
+-- .TP
+-- oversized
+-- Number of allocations too large for the pool.
+module(...,package.seeall)
+
+require("dnsjit.core.pool_h")
+local ffi = require("ffi")
+local C = ffi.C
+
+local t_name = "core_pool_t"
+local core_pool_t
+local Pool = {}
+
+-- Create a new Pool, the optional
+-- .I slab_size
+-- sets the size of the slabs allocated when a size class runs out of
+-- memory.
+function Pool.new(slab_size)
+    local self = core_pool_t()
+    C.core_pool_init(self, slab_size or 0)
+    ffi.gc(self, C.core_pool_destroy)
+    return self
+end
+
+-- Return the Log object to control logging of this instance or module.
+function Pool:log()
+    if self == nil then
+        return C.core_pool_log()
+    end
+    return self._log
+end
+
+-- Return information to use when sharing this object between threads.
+function Pool:share()
+    return ffi.cast("void*", self), t_name.."*", "dnsjit.core.pool"
+end
+
+core_pool_t = ffi.metatype(t_name, { __index = Pool })
+
+-- dnsjit.core.object (3),
+-- dnsjit.filter.copy (3)
+return Pool
@@ -21,3 +21,4 @@
 // lua:require("dnsjit.core.object_h")
 
 typedef void (*core_receiver_t)(void* ctx, const core_object_t* obj);
+typedef void (*core_receiver_batch_t)(void* ctx, const core_object_t** objs, size_t num);
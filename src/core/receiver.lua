@@ -22,6 +22,19 @@
 --
 -- Receiver interfaces are used by input, filter and output modules to pass
 -- objects for processing.
+-- .SS Batches
+-- Modules that can process many objects at once also have a batch receiver,
+-- returned by
+-- .IR receive_batch ()
+-- with the same context as
+-- .IR receive (),
+-- which takes an array of objects.
+-- Modules that send objects check if their receiver has
+-- .IR receive_batch ()
+-- and if so collect objects into batches, otherwise they send each object
+-- to the per-object receiver as before so modules without batch support
+-- work unchanged.
+-- Objects in a batch are only valid until the batch receiver returns.
 module(...,package.seeall)
 
 -- dnsjit.core.object (3)
@@ -18,21 +18,39 @@
  * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "config.h"
 
 #include "globals.h"
 #include "core/assert.h"
 #include "core/thread.h"
 
+#include <errno.h>
 #include <string.h>
 #include <lualib.h>
 #include <lauxlib.h>
+#ifdef HAVE_PTHREAD_NP_H
+#include <pthread_np.h>
+#endif
+#if defined(HAVE_NUMA_H) && defined(HAVE_LIBNUMA)
+#include <numa.h>
+#define USE_NUMA 1
+#endif
 
 static core_log_t    _log      = LOG_T_INIT("core.thread");
 static core_thread_t _defaults = {
     LOG_T_INIT_OBJ("core.thread"),
     0, 0, 0, 0,
     PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    0, 0,
+    0, 0, -1, 0, CORE_THREAD_SCHED_OTHER, 0,
+    0
+};
+static core_thread_factory_t _factory_defaults = {
+    LOG_T_INIT_OBJ("core.thread"),
     0, 0
 };
 
@@ -54,25 +72,71 @@ void core_thread_destroy(core_thread_t* self)
     mlassert_self();
 
     free(self->bytecode);
+    free(self->cpus);
     while ((item = self->stack)) {
         self->stack = item->next;
         free(item);
     }
 }
 
+/*
+ * Pin the thread before creating the Lua state so that its memory is
+ * allocated (first touched) on the right NUMA node.
+ */
+static void _pin(core_thread_t* self)
+{
+    if (self->cpus_len) {
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+        cpu_set_t set;
+        size_t    i;
+        int       err;
+
+        CPU_ZERO(&set);
+        for (i = 0; i < self->cpus_len; i++) {
+            CPU_SET(self->cpus[i], &set);
+        }
+        if ((err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set))) {
+            lcritical("pthread_setaffinity_np() error: %s", core_log_errstr(err));
+        }
+#endif
+    }
+
+    if (self->numa_node > -1) {
+#ifdef USE_NUMA
+        if (numa_available() < 0) {
+            lwarning("NUMA not available, not binding to node %d", self->numa_node);
+            return;
+        }
+        if (!self->cpus_len && numa_run_on_node(self->numa_node)) {
+            lcritical("numa_run_on_node(%d) error: %s", self->numa_node, core_log_errstr(errno));
+        }
+        numa_set_preferred(self->numa_node);
+#else
+        lwarning("built without NUMA support, not binding to node %d", self->numa_node);
+#endif
+    }
+}
+
 static void* _thread(void* vp)
 {
     core_thread_t* self = (core_thread_t*)vp;
     lua_State*     L;
     mlassert_self();
 
-    // TODO: move to dnsjit_newstate()
-    L = luaL_newstate();
+    _pin(self);
+
+    L = dnsjit_newstate();
     lassert(L, "could not create new Lua state");
-    luaL_openlibs(L);
-    dnsjit_globals(L);
 
     for (;;) {
+        if (self->factory && self->factory->bytecode) {
+            if (luaL_loadbuffer(L, self->factory->bytecode, self->factory->bytecode_len, "factory")
+                || lua_pcall(L, 0, 0, 0)) {
+                lcritical("%s", lua_tostring(L, -1));
+                break;
+            }
+        }
+
         lua_getfield(L, LUA_GLOBALSINDEX, "require");
         lua_pushstring(L, "dnsjit.core.thread");
         if (lua_pcall(L, 1, 1, 0)) {
@@ -94,21 +158,50 @@ static void* _thread(void* vp)
 
 int core_thread_start(core_thread_t* self, const char* bytecode, size_t len)
 {
-    int err;
+    pthread_attr_t attr;
+    int            err;
     mlassert_self();
 
     if (self->bytecode) {
         lfatal("bytecode already set");
     }
 
+    if ((err = pthread_attr_init(&attr))) {
+        lcritical("pthread_attr_init() error: %s", core_log_errstr(err));
+        return -1;
+    }
+    if (self->stack_size && (err = pthread_attr_setstacksize(&attr, self->stack_size))) {
+        lcritical("pthread_attr_setstacksize() error: %s", core_log_errstr(err));
+        pthread_attr_destroy(&attr);
+        return -1;
+    }
+    if (self->sched != CORE_THREAD_SCHED_OTHER) {
+        struct sched_param param;
+        int                policy = self->sched == CORE_THREAD_SCHED_FIFO ? SCHED_FIFO : SCHED_RR;
+
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = self->priority;
+        if ((err = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED))
+            || (err = pthread_attr_setschedpolicy(&attr, policy))
+            || (err = pthread_attr_setschedparam(&attr, &param))) {
+            lcritical("unable to set scheduling policy/priority: %s", core_log_errstr(err));
+            pthread_attr_destroy(&attr);
+            return -1;
+        }
+    }
+
     lfatal_oom(self->bytecode = malloc(len));
     memcpy(self->bytecode, bytecode, len);
     self->bytecode_len = len;
 
-    if ((err = pthread_create(&self->thr_id, 0, _thread, (void*)self))) {
+    if ((err = pthread_create(&self->thr_id, &attr, _thread, (void*)self))) {
         lcritical("pthread_create() error: %s", core_log_errstr(err));
+        pthread_attr_destroy(&attr);
+        free(self->bytecode);
+        self->bytecode = 0;
         return -1;
     }
+    pthread_attr_destroy(&attr);
 
     return 0;
 }
@@ -126,6 +219,37 @@ int core_thread_stop(core_thread_t* self)
     return 0;
 }
 
+int core_thread_set_affinity(core_thread_t* self, const int* cpus, size_t len)
+{
+    size_t i;
+    mlassert_self();
+    lassert(cpus || !len, "cpus is nil");
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    for (i = 0; i < len; i++) {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) {
+            lcritical("invalid cpu %d", cpus[i]);
+            return -1;
+        }
+    }
+
+    free(self->cpus);
+    self->cpus     = 0;
+    self->cpus_len = 0;
+    if (len) {
+        lfatal_oom(self->cpus = malloc(sizeof(int) * len));
+        memcpy(self->cpus, cpus, sizeof(int) * len);
+        self->cpus_len = len;
+    }
+
+    return 0;
+#else
+    (void)i;
+    lcritical("setting CPU affinity is not supported on this platform");
+    return -1;
+#endif
+}
+
 inline static void _push(core_thread_t* self, core_thread_item_t* item)
 {
     if (pthread_mutex_lock(&self->lock)) {
@@ -227,3 +351,62 @@ const core_thread_item_t* core_thread_pop(core_thread_t* self)
 
     return self->at;
 }
+
+void core_thread_factory_init(core_thread_factory_t* self)
+{
+    mlassert_self();
+
+    *self = _factory_defaults;
+}
+
+void core_thread_factory_destroy(core_thread_factory_t* self)
+{
+    mlassert_self();
+
+    free(self->bytecode);
+}
+
+/*
+ * Run the builder function in a scratch Lua state, it loads the modules
+ * and returns a bytecode chunk that recreates them in a new state with one
+ * pass over all their C definitions.
+ */
+int core_thread_factory_build(core_thread_factory_t* self, const char* builder, size_t builder_len, const char* modules, size_t modules_len)
+{
+    lua_State*  L;
+    const char* bytecode;
+    size_t      len;
+    mlassert_self();
+    lassert(builder, "builder is nil");
+    lassert(modules || !modules_len, "modules is nil");
+
+    if (!(L = dnsjit_newstate())) {
+        lcritical("could not create new Lua state");
+        return -1;
+    }
+
+    if (luaL_loadbuffer(L, builder, builder_len, "builder")) {
+        lcritical("%s", lua_tostring(L, -1));
+        lua_close(L);
+        return -1;
+    }
+    lua_pushlstring(L, modules ? modules : "", modules_len);
+    if (lua_pcall(L, 1, 1, 0)) {
+        lcritical("%s", lua_tostring(L, -1));
+        lua_close(L);
+        return -1;
+    }
+    if (!(bytecode = lua_tolstring(L, -1, &len))) {
+        lcritical("builder did not return bytecode");
+        lua_close(L);
+        return -1;
+    }
+
+    free(self->bytecode);
+    lfatal_oom(self->bytecode = malloc(len));
+    memcpy(self->bytecode, bytecode, len);
+    self->bytecode_len = len;
+
+    lua_close(L);
+    return 0;
+}
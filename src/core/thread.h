@@ -24,6 +24,7 @@
 #define __dnsjit_core_thread_h
 
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 
 #include <dnsjit/core/thread.hh>
@@ -31,6 +31,18 @@ struct core_thread_item {
     double num;
 };
 
+typedef enum core_thread_sched {
+    CORE_THREAD_SCHED_OTHER = 0,
+    CORE_THREAD_SCHED_FIFO  = 1,
+    CORE_THREAD_SCHED_RR    = 2
+} core_thread_sched_t;
+
+typedef struct core_thread_factory {
+    core_log_t _log;
+    char*      bytecode;
+    size_t     bytecode_len;
+} core_thread_factory_t;
+
 typedef struct core_thread {
     core_log_t                _log;
     pthread_t                 thr_id;
@@ -42,6 +54,15 @@ typedef struct core_thread {
 
     char*  bytecode;
     size_t bytecode_len;
+
+    int*                cpus;
+    size_t              cpus_len;
+    int                 numa_node;
+    size_t              stack_size;
+    core_thread_sched_t sched;
+    int                 priority;
+
+    const core_thread_factory_t* factory;
 } core_thread_t;
 
 core_log_t* core_thread_log();
@@ -50,7 +71,12 @@ void                      core_thread_init(core_thread_t* self);
 void                      core_thread_destroy(core_thread_t* self);
 int                       core_thread_start(core_thread_t* self, const char* bytecode, size_t len);
 int                       core_thread_stop(core_thread_t* self);
+int                       core_thread_set_affinity(core_thread_t* self, const int* cpus, size_t len);
 void                      core_thread_push(core_thread_t* self, void* ptr, const char* type, size_t type_len, const char* module, size_t module_len);
 void                      core_thread_push_string(core_thread_t* self, const char* str, size_t len);
 void                      core_thread_push_number(core_thread_t* self, double num);
 const core_thread_item_t* core_thread_pop(core_thread_t* self);
+
+void core_thread_factory_init(core_thread_factory_t* self);
+void core_thread_factory_destroy(core_thread_factory_t* self);
+int  core_thread_factory_build(core_thread_factory_t* self, const char* builder, size_t builder_len, const char* modules, size_t modules_len);
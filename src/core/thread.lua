@@ -31,6 +31,53 @@
 -- the thread stack.
 -- The Thread object and any other objects passed to the thread needs to be
 -- kept alive as long as the thread is running.
+-- .SS Pinning and scheduling
+--   local thr = require("dnsjit.core.thread").new()
+--   thr:affinity(2, 3)
+--   thr.numa_node = 0
+--   thr.stack_size = 1024 * 1024
+--   thr.sched = "CORE_THREAD_SCHED_FIFO"
+--   thr.priority = 10
+--   thr:start(...)
+-- .LP
+-- The CPU affinity, NUMA node, stack size and scheduling policy/priority
+-- must be set before the thread is started.
+-- The thread is pinned before its Lua state is created so that the memory
+-- of the state is allocated on the NUMA node of the CPUs it runs on.
+-- .SS Workers
+--   local thread = require("dnsjit.core.thread")
+--   local workers = thread.workers(4, function(thr)
+--       local n, chan = thr:pop(2)
+--       ...
+--   end, { cpus = { 4, 5, 6, 7 } }, chan)
+--   ...
+--   for _, thr in pairs(workers) do
+--       thr:stop()
+--   end
+-- .SS Attributes
+-- .TP
+-- numa_node
+-- The NUMA node to run the thread on and to prefer for memory allocations,
+-- -1 (default) for none.
+-- Requires dnsjit to be built with libnuma.
+-- .TP
+-- stack_size
+-- The stack size of the thread, 0 (default) for the system default.
+-- .TP
+-- sched
+-- The scheduling policy of the thread,
+-- .IR CORE_THREAD_SCHED_OTHER " (default), " CORE_THREAD_SCHED_FIFO
+-- or
+-- .IR CORE_THREAD_SCHED_RR .
+-- Real-time policies usually require privileges.
+-- .TP
+-- priority
+-- The scheduling priority used with the FIFO and RR policies.
+-- .TP
+-- factory
+-- The thread state factory to use when creating the Lua state of the thread,
+-- see
+-- .IR factory ().
 module(...,package.seeall)
 
 require("dnsjit.core.thread_h")
@@ -39,6 +86,7 @@ local C = ffi.C
 
 local t_name = "core_thread_t"
 local core_thread_t
+local core_thread_factory_t
 local Thread = {
     _in_thread = function(thr, bytecode)
         thr = ffi.cast("core_thread_t*", thr)
@@ -46,6 +94,50 @@ local Thread = {
     end
 }
 
+-- Run in a scratch Lua state by the factory, record all C definitions made
+-- while loading the modules and return a chunk that makes them in one go,
+-- preloads the bytecode of the modules and then requires them.
+local function _build_factory(modules)
+    local ffi = require("ffi")
+    local cdef, defs = ffi.cdef, {}
+    ffi.cdef = function(def)
+        table.insert(defs, def)
+        return cdef(def)
+    end
+    local loaded = {}
+    for name in pairs(package.loaded) do
+        loaded[name] = true
+    end
+    local mods = { "dnsjit.core.thread" }
+    for name in modules:gmatch("%S+") do
+        table.insert(mods, name)
+    end
+    for _, name in ipairs(mods) do
+        require(name)
+    end
+    ffi.cdef = cdef
+
+    local src = { "local ffi = require(\"ffi\")" }
+    table.insert(src, string.format("ffi.cdef(%q)", table.concat(defs, "\n")))
+    for name in pairs(package.loaded) do
+        if not loaded[name] and name:match("_h$") then
+            table.insert(src, string.format("package.loaded[%q] = {}", name))
+        elseif not loaded[name] then
+            for n = 2, #package.loaders do
+                local chunk = package.loaders[n](name)
+                if type(chunk) == "function" then
+                    table.insert(src, string.format("package.preload[%q] = loadstring(%q)", name, string.dump(chunk, true)))
+                    break
+                end
+            end
+        end
+    end
+    for _, name in ipairs(mods) do
+        table.insert(src, string.format("require(%q)", name))
+    end
+    return string.dump(assert(loadstring(table.concat(src, "\n"))), true)
+end
+
 -- Create a new Thread object.
 function Thread.new()
     local self = core_thread_t()
@@ -70,6 +162,110 @@ function Thread:start(func)
     return C.core_thread_start(self, bc, #bc)
 end
 
+-- Set the CPU affinity of the thread to the given CPU number(s), or a table
+-- of CPU numbers.
+-- Returns 0 on success.
+function Thread:affinity(...)
+    local cpus = {...}
+    if type(cpus[1]) == "table" then
+        cpus = cpus[1]
+    end
+    return C.core_thread_set_affinity(self, ffi.new("int[?]", #cpus, cpus), #cpus)
+end
+
+-- Create and start
+-- .I num
+-- threads running the same function, each thread gets its number (starting
+-- at 1) pushed onto its stack followed by the optional arguments.
+-- The optional table
+-- .I opts
+-- may contain
+-- .I cpus
+-- (a table of CPU numbers, worker N is pinned to the Nth CPU modulo the
+-- number of CPUs),
+-- .IR numa_node ,
+-- .IR stack_size ,
+-- .IR sched ,
+-- .I priority
+-- and
+-- .I factory
+-- which are applied to all threads.
+-- Returns a table with the threads or nil if a thread failed to start, in
+-- which case the threads already started are waited for with
+-- .IR stop ()
+-- before returning so the function must return on its own.
+function Thread.workers(num, func, opts, ...)
+    local threads = {}
+    local bc = string.dump(func)
+    local function failed()
+        for _, thr in pairs(threads) do
+            thr:stop()
+        end
+    end
+    opts = opts or {}
+    for n = 1, num do
+        local thr = Thread.new()
+        if opts.cpus and #opts.cpus > 0 then
+            if thr:affinity(opts.cpus[(n - 1) % #opts.cpus + 1]) ~= 0 then
+                failed()
+                return
+            end
+        end
+        if opts.numa_node ~= nil then
+            thr.numa_node = opts.numa_node
+        end
+        if opts.stack_size ~= nil then
+            thr.stack_size = opts.stack_size
+        end
+        if opts.sched ~= nil then
+            thr.sched = opts.sched
+        end
+        if opts.priority ~= nil then
+            thr.priority = opts.priority
+        end
+        if opts.factory ~= nil then
+            thr.factory = opts.factory
+        end
+        if C.core_thread_start(thr, bc, #bc) ~= 0 then
+            failed()
+            return
+        end
+        thr:push(n, ...)
+        table.insert(threads, thr)
+    end
+    return threads
+end
+
+-- Create a thread state factory that preloads the given list of modules
+-- in threads using it.
+-- The C definitions of the modules and their dependencies are collected
+-- once and given to the thread's new Lua state in one pass, instead of
+-- each module defining its own when required, and the bytecode of the
+-- modules is set in
+-- .I package.preload
+-- so they are not searched for.
+-- The C definitions are still parsed once in each new state, use
+-- .I examples/thread_startup.lua
+-- to compare the startup time with and without a factory.
+-- The factory needs to be kept alive as long as threads are being started
+-- with it.
+--   local thread = require("dnsjit.core.thread")
+--   local factory = thread.factory({ "dnsjit.core.channel", "dnsjit.filter.layer" })
+--   local thr = thread.new()
+--   thr.factory = factory
+--   thr:start(...)
+function Thread.factory(modules)
+    local self = core_thread_factory_t()
+    C.core_thread_factory_init(self)
+    ffi.gc(self, C.core_thread_factory_destroy)
+    local builder = string.dump(_build_factory)
+    local mods = table.concat(modules or {}, " ")
+    if C.core_thread_factory_build(self, builder, #builder, mods, #mods) ~= 0 then
+        return
+    end
+    return self
+end
+
 -- Wait for the thread to return.
 -- Returns 0 on success.
 function Thread:stop()
@@ -136,6 +332,7 @@ function Thread:pop(num)
 end
 
 core_thread_t = ffi.metatype(t_name, { __index = Thread })
+core_thread_factory_t = ffi.typeof("core_thread_factory_t")
 
 -- dnsjit.core.channel (3)
 return Thread
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <dnsjit/core/log.h>
+#include <dnsjit/core/channel.h>
+
+#ifndef __dnsjit_core_wait_h
+#define __dnsjit_core_wait_h
+
+#include <ck_pr.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Waiting shared by core.channel and core.broadcast using the strategies
+ * of core_channel_wait_t. With ADAPTIVE a waiter spins up to a number of
+ * times and then sleeps on a condition, the other side only takes the lock
+ * to wake it when the waiter count says someone is sleeping.
+ */
+
+typedef bool (*core_wait_ready_t)(void* ctx);
+
+static inline void core_wait_count(uint64_t* counter, uint64_t n)
+{
+#ifdef CK_F_PR_ADD_64
+    ck_pr_add_64(counter, n);
+#else
+    *counter += n;
+#endif
+}
+
+/*
+ * Sleep on the condition unless ready() returns true once registered as a
+ * waiter, it must be called with the same lock held by the side waking.
+ */
+static inline void core_wait_sleep(core_log_t* log, pthread_mutex_t* lock, pthread_cond_t* cond, unsigned int* waiters, uint64_t* sleeps, core_wait_ready_t ready, void* ctx)
+{
+    if (pthread_mutex_lock(lock)) {
+        core_log_fatal(log, __FILE__, __LINE__, "mutex lock failed");
+    }
+    ck_pr_inc_uint(waiters);
+    ck_pr_fence_memory();
+    if (!ready(ctx)) {
+        core_wait_count(sleeps, 1);
+        if (pthread_cond_wait(cond, lock)) {
+            core_log_fatal(log, __FILE__, __LINE__, "cond wait failed");
+        }
+    }
+    ck_pr_dec_uint(waiters);
+    if (pthread_mutex_unlock(lock)) {
+        core_log_fatal(log, __FILE__, __LINE__, "mutex unlock failed");
+    }
+}
+
+/*
+ * Wait once according to the strategy, returns true if the spins are used
+ * up and the caller should sleep with core_wait_sleep().
+ */
+static inline bool core_wait_spin(core_channel_wait_t wait, unsigned int spin, unsigned int* spins)
+{
+    switch (wait) {
+    case CORE_CHANNEL_WAIT_YIELD:
+        sched_yield();
+        break;
+    case CORE_CHANNEL_WAIT_SPIN:
+        ck_pr_stall();
+        break;
+    default:
+        if (*spins < spin) {
+            ck_pr_stall();
+            break;
+        }
+        return true;
+    }
+    (*spins)++;
+    return false;
+}
+
+/*
+ * Wake one or all waiters sleeping on the condition.
+ */
+static inline void core_wait_signal(core_log_t* log, pthread_mutex_t* lock, pthread_cond_t* cond, bool all)
+{
+    if (pthread_mutex_lock(lock)) {
+        core_log_fatal(log, __FILE__, __LINE__, "mutex lock failed");
+    }
+    if (all ? pthread_cond_broadcast(cond) : pthread_cond_signal(cond)) {
+        core_log_fatal(log, __FILE__, __LINE__, "cond signal failed");
+    }
+    if (pthread_mutex_unlock(lock)) {
+        core_log_fatal(log, __FILE__, __LINE__, "mutex unlock failed");
+    }
+}
+
+/*
+ * Wake waiters if there are any, only ADAPTIVE sleeps.
+ */
+static inline void core_wait_wake(core_log_t* log, core_channel_wait_t wait, pthread_mutex_t* lock, pthread_cond_t* cond, unsigned int* waiters, bool all)
+{
+    if (wait != CORE_CHANNEL_WAIT_ADAPTIVE) {
+        return;
+    }
+    ck_pr_fence_memory();
+    if (!ck_pr_load_uint(waiters)) {
+        return;
+    }
+    core_wait_signal(log, lock, cond, all);
+}
+
+#endif
@@ -39,9 +39,10 @@ int main(int argc, char* argv[])
         exit(1);
     }
 
-    L = luaL_newstate();
-    luaL_openlibs(L);
-    dnsjit_globals(L);
+    if (!(L = dnsjit_newstate())) {
+        glcritical("could not create new Lua state");
+        return 1;
+    }
 
     lua_createtable(L, argc, 0);
     for (n = 0; n < argc; n++) {
@@ -26,6 +26,8 @@ module(...,package.seeall)
 -- dnsjit.filter.copy (3),
 -- dnsjit.filter.ipsplit (3),
 -- dnsjit.filter.layer (3),
+-- dnsjit.filter.match (3),
 -- dnsjit.filter.split (3),
+-- dnsjit.filter.tcpdns (3),
 -- dnsjit.filter.timing (3)
 return
@@ -27,7 +27,8 @@ static core_log_t    _log      = LOG_T_INIT("filter.copy");
 static filter_copy_t _defaults = {
     LOG_T_INIT_OBJ("filter.copy"),
     0, 0,
-    0
+    0, 0,
+    0, 0
 };
 
 core_log_t* filter_copy_log()
@@ -103,9 +104,13 @@ void filter_copy_set(filter_copy_t* self, int32_t obj_type)
     case CORE_OBJECT_LINUXSLL2:
         self->copy |= 0x10000;
         break;
+    case CORE_OBJECT_PACKET:
+        self->copy |= 0x20000;
+        break;
     default:
         lfatal("unknown type %d", obj_type);
     }
+    self->types |= (uint64_t)1 << obj_type;
 }
 
 uint64_t filter_copy_get(filter_copy_t* self, int32_t obj_type)
@@ -147,6 +152,8 @@ uint64_t filter_copy_get(filter_copy_t* self, int32_t obj_type)
         return self->copy & 0x8000;
     case CORE_OBJECT_LINUXSLL2:
         return self->copy & 0x10000;
+    case CORE_OBJECT_PACKET:
+        return self->copy & 0x20000;
     default:
         lfatal("unknown type %d", obj_type);
     }
@@ -163,10 +170,19 @@ static void _receive(filter_copy_t* self, const core_object_t* obj)
     core_object_t*       current = NULL;
     const core_object_t* srcobj  = obj;
 
+    if (self->chain) {
+        if (!(outobj = core_object_copy_chain(obj, self->types, self->pool))) {
+            lnotice("object discarded (no types to copy)");
+            return;
+        }
+        self->recv(self->recv_ctx, outobj);
+        return;
+    }
+
     do {
         if (filter_copy_get(self, srcobj->obj_type)) {
             next    = current;
-            current = core_object_copy(srcobj);
+            current = core_object_copy_pool(srcobj, self->pool);
             if (next == NULL) {
                 next   = current;
                 outobj = current;
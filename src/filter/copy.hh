@@ -20,6 +20,7 @@
 
 // lua:require("dnsjit.core.log")
 // lua:require("dnsjit.core.receiver_h")
+// lua:require("dnsjit.core.pool_h")
 
 typedef struct filter_copy {
     core_log_t _log;
@@ -27,7 +28,11 @@ typedef struct filter_copy {
     core_receiver_t recv;
     void*           recv_ctx;
 
-    uint64_t copy;
+    uint64_t     copy;
+    core_pool_t* pool;
+
+    int      chain;
+    uint64_t types;
 } filter_copy_t;
 
 core_log_t* filter_copy_log();
@@ -26,6 +26,18 @@
 --
 -- Filter to create a copy of the object chain with selected object types.
 -- The user is responsible for manually freeing the created object chain.
+-- .SS Single allocation
+-- With
+-- .IR chain ()
+-- enabled the whole copy, including packet and payload bytes, is made in
+-- one allocation.
+-- Such a copy is freed by freeing only the first object in the chain,
+-- the other objects in it must not be freed.
+--   copy:obj_type(object.PAYLOAD)
+--   copy:obj_type(object.UDP)
+--   copy:chain(true)
+--   ...
+--   obj:free()
 module(...,package.seeall)
 
 require("dnsjit.filter.copy_h")
@@ -61,6 +73,26 @@ function Copy:obj_type(obj_type)
     C.filter_copy_set(self.obj, obj_type)
 end
 
+-- Set the
+-- .BR dnsjit.core.pool (3)
+-- to allocate copies from, by default copies are allocated from the heap.
+-- The pool must only be used by this filter (or others running in the same
+-- thread) and must outlive all copies made.
+function Copy:pool(pool)
+    self.obj.pool = pool
+    self._pool = pool
+end
+
+-- Enable or disable copying the object chain in one allocation, see
+-- .BR "Single allocation" .
+function Copy:chain(bool)
+    if bool == true then
+        self.obj.chain = 1
+    else
+        self.obj.chain = 0
+    end
+end
+
 -- Return the C functions and context for receiving objects.
 function Copy:receive()
     return C.filter_copy_receiver(self.obj), self.obj
@@ -71,4 +103,5 @@ function Copy:receiver(o)
     self.obj.recv, self.obj.recv_ctx = o:receive()
 end
 
+-- dnsjit.core.pool (3)
 return Copy
@@ -24,6 +24,7 @@
 #include "core/assert.h"
 #include "core/object/ip.h"
 #include "core/object/ip6.h"
+#include "core/object/packet.h"
 #include "lib/trie.h"
 
 #include <string.h>
@@ -215,8 +216,11 @@ static void _receive(filter_ipsplit_t* self, const core_object_t* obj)
 {
     mlassert_self();
 
-    /* Find ip/ip6 object in chain. */
+    /* Find ip/ip6 object in chain, the packet context has it directly. */
     core_object_t* pkt = (core_object_t*)obj;
+    if (obj->obj_type == CORE_OBJECT_PACKET) {
+        pkt = (core_object_t*)((const core_object_packet_t*)obj)->ip;
+    }
     while (pkt != NULL) {
         if (pkt->obj_type == CORE_OBJECT_IP || pkt->obj_type == CORE_OBJECT_IP6)
             break;
@@ -255,6 +259,14 @@ static void _receive(filter_ipsplit_t* self, const core_object_t* obj)
 
     client = (_client_t*)*node;
     _overwrite(self, pkt, client);
+    if (obj->obj_type == CORE_OBJECT_PACKET) {
+        core_object_packet_t* packet = (core_object_packet_t*)obj;
+        if (self->overwrite == IPSPLIT_OVERWRITE_SRC) {
+            memcpy(packet->src, client->id, sizeof(client->id));
+        } else if (self->overwrite == IPSPLIT_OVERWRITE_DST) {
+            memcpy(packet->dst, client->id, sizeof(client->id));
+        }
+    }
     client->recv->recv(client->recv->ctx, obj);
 }
 
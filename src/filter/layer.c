@@ -23,6 +23,7 @@
 #include "filter/layer.h"
 #include "core/assert.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <pcap/pcap.h>
 #include <sys/types.h>
@@ -64,6 +65,61 @@
 
 #define N_IEEE802 3
 
+/*
+ * Fragment reassembly, a fixed number of datagrams can be reassembled at
+ * the same time each with a buffer for the largest datagram and a bitmap
+ * of which 8 byte blocks have been received.
+ * Datagrams are found by a hash of the key and are also kept in the order
+ * of their first fragment so the oldest can be expired, or evicted when
+ * all are in use.
+ * A reassembled datagram is produced from its buffer which is given back
+ * when the next object is received or produced.
+ */
+#define DEFRAG_SIZE 65536
+#define DEFRAG_BITS (DEFRAG_SIZE / 64)
+#define DEFRAG_HELD 2
+
+/*
+ * When only some packets are wanted the allowed protocols and ports are
+ * kept as bitmaps, a packet is skipped as soon as its protocol or ports
+ * are known not to be allowed and any packet that did not reach an allowed
+ * protocol is skipped after parsing.
+ * No ports means any port.
+ */
+#define SKIPPED 3
+
+typedef struct _only {
+    uint8_t proto[32];
+    uint8_t port[8192];
+    size_t  ports;
+} _only_t;
+
+typedef struct _frag_key {
+    uint8_t  src[16], dst[16];
+    uint32_t id;
+    uint8_t  v, proto;
+} _frag_key_t;
+
+typedef struct _frag {
+    struct _frag *  hnext, *prev, *next;
+    _frag_key_t     key;
+    size_t          hash;
+    core_timespec_t ts;
+    size_t          total, end, received;
+    uint8_t         proto;
+    uint8_t*        buf;
+    uint8_t*        bits;
+} _frag_t;
+
+typedef struct _defrag {
+    filter_layer_defrag_stats_t stats;
+    size_t                      timeout, mask;
+    _frag_t**                   bucket;
+    _frag_t*                    frags;
+    _frag_t *                   free, *pending, *head, *tail;
+    uint8_t*                    mem;
+} _defrag_t;
+
 static core_log_t     _log      = LOG_T_INIT("filter.layer");
 static filter_layer_t _defaults = {
     LOG_T_INIT_OBJ("filter.layer"),
@@ -83,7 +139,18 @@ static filter_layer_t _defaults = {
     CORE_OBJECT_ICMP6_INIT(0),
     CORE_OBJECT_UDP_INIT(0),
     CORE_OBJECT_TCP_INIT(0),
-    CORE_OBJECT_PAYLOAD_INIT(0)
+    CORE_OBJECT_PAYLOAD_INIT(0),
+    CORE_OBJECT_PACKET_INIT(0),
+    0,
+    0,
+    0, 0,
+    CORE_OBJECT_ETHER_INIT(0),
+    CORE_OBJECT_IP_INIT(0),
+    CORE_OBJECT_IP6_INIT(0),
+    CORE_OBJECT_UDP_INIT(0),
+    CORE_OBJECT_GRE_INIT(0),
+    0, 0, 0,
+    0, 0, 0, 0
 };
 
 core_log_t* filter_layer_log()
@@ -98,9 +165,122 @@ void filter_layer_init(filter_layer_t* self)
     *self = _defaults;
 }
 
+static void _defrag_free(_defrag_t* defrag)
+{
+    if (defrag) {
+        free(defrag->mem);
+        free(defrag->frags);
+        free(defrag->bucket);
+        free(defrag);
+    }
+}
+
 void filter_layer_destroy(filter_layer_t* self)
 {
     mlassert_self();
+
+    free(self->lanes);
+    free(self->batch);
+    _defrag_free(self->defrag);
+    free(self->only);
+}
+
+void filter_layer_defrag(filter_layer_t* self, size_t max, size_t timeout)
+{
+    _defrag_t* defrag;
+    size_t     n, buckets = 1;
+    mlassert_self();
+
+    _defrag_free(self->defrag);
+    self->defrag = 0;
+    if (!max) {
+        return;
+    }
+
+    while (buckets < max * 2) {
+        buckets <<= 1;
+    }
+
+    lfatal_oom(defrag = calloc(1, sizeof(_defrag_t)));
+    lfatal_oom(defrag->bucket = calloc(buckets, sizeof(_frag_t*)));
+    lfatal_oom(defrag->frags = calloc(max, sizeof(_frag_t)));
+    lfatal_oom(defrag->mem = malloc(max * (DEFRAG_SIZE + DEFRAG_BITS)));
+    defrag->mask    = buckets - 1;
+    defrag->timeout = timeout;
+    for (n = 0; n < max; n++) {
+        defrag->frags[n].buf  = defrag->mem + n * (DEFRAG_SIZE + DEFRAG_BITS);
+        defrag->frags[n].bits = defrag->frags[n].buf + DEFRAG_SIZE;
+        defrag->frags[n].next = defrag->free;
+        defrag->free          = &defrag->frags[n];
+    }
+
+    self->defrag = defrag;
+}
+
+void filter_layer_defrag_stats(const filter_layer_t* self, filter_layer_defrag_stats_t* stats)
+{
+    mlassert_self();
+    mlassert(stats, "stats is nil");
+
+    if (self->defrag) {
+        *stats = ((const _defrag_t*)self->defrag)->stats;
+    } else {
+        memset(stats, 0, sizeof(filter_layer_defrag_stats_t));
+    }
+}
+
+static _only_t* _only(filter_layer_t* self)
+{
+    if (!self->only) {
+        lfatal_oom(self->only = calloc(1, sizeof(_only_t)));
+    }
+    return self->only;
+}
+
+void filter_layer_only_proto(filter_layer_t* self, uint8_t proto)
+{
+    mlassert_self();
+
+    _only(self)->proto[proto >> 3] |= 1 << (proto & 7);
+}
+
+void filter_layer_only_port(filter_layer_t* self, uint16_t port)
+{
+    _only_t* only;
+    mlassert_self();
+
+    only = _only(self);
+    if (!(only->port[port >> 3] & (1 << (port & 7)))) {
+        only->port[port >> 3] |= 1 << (port & 7);
+        only->ports++;
+    }
+}
+
+void filter_layer_only_clear(filter_layer_t* self)
+{
+    mlassert_self();
+
+    free(self->only);
+    self->only = 0;
+}
+
+static inline int _only_proto(const filter_layer_t* self, uint8_t proto)
+{
+    const _only_t* only = self->only;
+
+    return only->proto[proto >> 3] & (1 << (proto & 7));
+}
+
+static inline int _only_ports(filter_layer_t* self, uint16_t sport, uint16_t dport)
+{
+    const _only_t* only = self->only;
+
+    if (!only->ports || only->port[sport >> 3] & (1 << (sport & 7)) || only->port[dport >> 3] & (1 << (dport & 7))) {
+        self->allowed = 1;
+        return 1;
+    }
+
+    return 0;
 }
 
 #define need4x2(v1, v2, p, l) \
@@ -181,10 +361,134 @@ static inline uint32_t _need32(const void* ptr)
     p += x;                \
     l -= x
 
-// static int _ip(filter_layer_t* self, const core_object_t* obj, const unsigned char* pkt, size_t len);
+#define VXLAN_PORT 4789
+#define GENEVE_PORT 6081
+
+static inline int _ip(filter_layer_t* self, const core_object_t* obj, const unsigned char* pkt, size_t len);
+static inline int _ether(filter_layer_t* self, core_object_ether_t* ether, const core_object_t* obj, const unsigned char* pkt, size_t len);
+
+/*
+ * Decapsulation reuses the objects of the layer for the inner packet, so
+ * the objects of the outer packet that could be reused are first moved to
+ * their outer storage and the chain is relinked to them.
+ * Only one level of tunnel is decapsulated, bit 1 of tunnel is set when
+ * the outer objects are in use and bit 2 when the inner Ethernet is.
+ */
+static const core_object_t* _outer(filter_layer_t* self, const core_object_t* obj)
+{
+    const core_object_t*  top = obj;
+    const core_object_t** ref = &top;
+
+    while (*ref) {
+        if (*ref == (core_object_t*)&self->ip) {
+            self->outer_ip = self->ip;
+            *ref           = (core_object_t*)&self->outer_ip;
+        } else if (*ref == (core_object_t*)&self->ip6) {
+            self->outer_ip6 = self->ip6;
+            *ref            = (core_object_t*)&self->outer_ip6;
+        } else if (*ref == (core_object_t*)&self->udp) {
+            self->outer_udp = self->udp;
+            *ref            = (core_object_t*)&self->outer_udp;
+        } else if (*ref == (core_object_t*)&self->gre) {
+            self->outer_gre = self->gre;
+            *ref            = (core_object_t*)&self->outer_gre;
+        }
+        ref = (const core_object_t**)&(*ref)->obj_prev;
+    }
+    self->tunnel |= 1;
+
+    return top;
+}
+
+/*
+ * MPLS label stack, the payload after the bottom of the stack is IP or,
+ * for a pseudowire with a control word, Ethernet.
+ */
+static inline int _mpls(filter_layer_t* self, const core_object_t* obj, const unsigned char* pkt, size_t len)
+{
+    int bottom;
+
+    do {
+        if (len < 4) {
+            self->produced = obj;
+            return 0;
+        }
+        bottom = pkt[2] & 0x1;
+        pkt += 4;
+        len -= 4;
+    } while (!bottom);
+
+    if (len) {
+        switch (*pkt >> 4) {
+        case 4:
+        case 6:
+            return _ip(self, obj, pkt, len);
+        case 0:
+            if (len > 4 && !(self->tunnel & 2)) {
+                self->tunnel |= 2;
+                return _ether(self, &self->inner_ether, obj, pkt + 4, len - 4);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    self->produced = obj;
+    return 0;
+}
+
+/*
+ * The payload of a tunnel by its protocol type.
+ */
+static inline int _decap(filter_layer_t* self, uint16_t type, const core_object_t* obj, const unsigned char* pkt, size_t len)
+{
+    switch (type) {
+    case ETHERTYPE_IP:
+    case ETHERTYPE_IPV6:
+        return _ip(self, _outer(self, obj), pkt, len);
+    case 0x6558: /* Transparent Ethernet Bridging */
+        return _ether(self, &self->inner_ether, _outer(self, obj), pkt, len);
+    case 0x8847: /* MPLS unicast */
+    case 0x8848: /* MPLS multicast */
+        return _mpls(self, _outer(self, obj), pkt, len);
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+/*
+ * Offset of a header within the packet bytes for the packet context, 0 if
+ * the context is not enabled or the header is not within the packet, such
+ * as in a reassembled datagram.
+ */
+static inline size_t _offset(filter_layer_t* self, const unsigned char* pkt)
+{
+    const unsigned char* bytes = self->packet.pcap->bytes;
+
+    if (!self->context || !bytes || pkt < bytes || pkt >= bytes + self->packet.pcap->caplen) {
+        return 0;
+    }
+    return pkt - bytes;
+}
 
 static inline int _proto(filter_layer_t* self, uint8_t proto, const core_object_t* obj, const unsigned char* pkt, size_t len)
 {
+    self->packet.l4_offset = _offset(self, pkt);
+
+    if (self->only) {
+        if (!_only_proto(self, proto)) {
+            /* tunnels are let through to check the inner packet */
+            if (proto != IPPROTO_GRE || !self->decap || self->tunnel) {
+                return SKIPPED;
+            }
+        } else if (proto != IPPROTO_UDP && proto != IPPROTO_TCP) {
+            self->allowed = 1;
+        }
+    }
+
     switch (proto) {
     case IPPROTO_GRE: {
         core_object_gre_t* gre = &self->gre;
@@ -192,29 +496,60 @@ static inline int _proto(filter_layer_t* self, uint8_t proto, const core_object_
 
         need16(gre->gre_flags, pkt, len);
         need16(gre->ether_type, pkt, len);
-
-        /* TODO: Incomplete, check RFC 1701 */
+        gre->checksum = gre->offset = 0;
+        gre->key = gre->sequence = 0;
 
         self->produced = (core_object_t*)gre;
 
-        // if (gre.gre_flags & 0x1) {
-        //     need16(gre.checksum, pkt, len);
-        // }
-        // if (gre.gre_flags & 0x4) {
-        //     need16(gre.key, pkt, len);
-        // }
-        // if (gre.gre_flags & 0x8) {
-        //     need16(gre.sequence, pkt, len);
-        // }
-        //
-        // switch (gre.ether_type) {
-        // case ETHERTYPE_IP:
-        // case ETHERTYPE_IPV6:
-        //     return _ip(self, (core_object_t*)gre, pkt, len);
-        //
-        // default:
-        //     break;
-        // }
+        switch (gre->gre_flags & 0x7) {
+        case 0: /* RFC 1701, RFC 2784 */
+            if (gre->gre_flags & 0xc000) {
+                need16(gre->checksum, pkt, len);
+                need16(gre->offset, pkt, len);
+            }
+            if (gre->gre_flags & 0x2000) {
+                need32(gre->key, pkt, len);
+            }
+            if (gre->gre_flags & 0x1000) {
+                need32(gre->sequence, pkt, len);
+            }
+            if (gre->gre_flags & 0x4000) {
+                uint16_t family;
+                uint8_t  sre_len;
+
+                /* skip the Source Route Entries up to the NULL SRE */
+                do {
+                    if (len < 4) {
+                        return 0;
+                    }
+                    family  = _need16(pkt);
+                    sre_len = pkt[3];
+                    pkt += 4;
+                    len -= 4;
+                    if (len < sre_len) {
+                        return 0;
+                    }
+                    pkt += sre_len;
+                    len -= sre_len;
+                } while (family || sre_len);
+            }
+            if (self->decap && !self->tunnel) {
+                return _decap(self, gre->ether_type, (core_object_t*)gre, pkt, len);
+            }
+            break;
+
+        case 1: /* RFC 2637 enhanced GRE, payload is PPP */
+            if (gre->gre_flags & 0x2000) {
+                need32(gre->key, pkt, len);
+            }
+            if (gre->gre_flags & 0x1000) {
+                need32(gre->sequence, pkt, len);
+            }
+            break;
+
+        default:
+            break;
+        }
         break;
     }
     case IPPROTO_ICMP: {
@@ -246,6 +581,11 @@ static inline int _proto(filter_layer_t* self, uint8_t proto, const core_object_
 
         need16(udp->sport, pkt, len);
         need16(udp->dport, pkt, len);
+        if (self->only && !_only_ports(self, udp->sport, udp->dport)) {
+            if (!self->decap || self->tunnel || (udp->dport != VXLAN_PORT && udp->dport != GENEVE_PORT)) {
+                return SKIPPED;
+            }
+        }
         need16(udp->ulen, pkt, len);
         need16(udp->sum, pkt, len);
 
@@ -262,6 +602,19 @@ static inline int _proto(filter_layer_t* self, uint8_t proto, const core_object_
         payload->payload = (uint8_t*)pkt;
 
         self->produced = (core_object_t*)payload;
+
+        if (self->decap && !self->tunnel) {
+            if (udp->dport == VXLAN_PORT && payload->len >= 8 && pkt[0] & 0x08) {
+                return _ether(self, &self->inner_ether, _outer(self, (core_object_t*)udp), pkt + 8, payload->len - 8);
+            }
+            if (udp->dport == GENEVE_PORT && payload->len >= 8 && !(pkt[0] & 0xc0)) {
+                size_t hlen = 8 + (pkt[0] & 0x3f) * 4;
+
+                if (payload->len >= hlen) {
+                    return _decap(self, _need16(pkt + 2), (core_object_t*)udp, pkt + hlen, payload->len - hlen);
+                }
+            }
+        }
         break;
     }
     case IPPROTO_TCP: {
@@ -271,6 +624,9 @@ static inline int _proto(filter_layer_t* self, uint8_t proto, const core_object_
 
         need16(tcp->sport, pkt, len);
         need16(tcp->dport, pkt, len);
+        if (self->only && !_only_ports(self, tcp->sport, tcp->dport)) {
+            return SKIPPED;
+        }
         need32(tcp->seq, pkt, len);
         need32(tcp->ack, pkt, len);
         need4x2(tcp->off, tcp->x2, pkt, len);
@@ -312,8 +668,250 @@ static inline int _proto(filter_layer_t* self, uint8_t proto, const core_object_
     return 0;
 }
 
+static inline size_t _frag_hash(const _frag_key_t* key)
+{
+    const uint8_t* p = (const uint8_t*)key;
+    uint32_t       h = 2166136261u;
+    size_t         n;
+
+    for (n = 0; n < sizeof(_frag_key_t); n++) {
+        h = (h ^ p[n]) * 16777619u;
+    }
+
+    return h;
+}
+
+static void _frag_unlink(_defrag_t* defrag, _frag_t* frag)
+{
+    _frag_t** p = &defrag->bucket[frag->hash & defrag->mask];
+
+    while (*p != frag) {
+        p = &(*p)->hnext;
+    }
+    *p = frag->hnext;
+
+    if (frag->prev) {
+        frag->prev->next = frag->next;
+    } else {
+        defrag->head = frag->next;
+    }
+    if (frag->next) {
+        frag->next->prev = frag->prev;
+    } else {
+        defrag->tail = frag->prev;
+    }
+}
+
+static void _frag_drop(_defrag_t* defrag, _frag_t* frag)
+{
+    _frag_unlink(defrag, frag);
+    frag->next   = defrag->free;
+    defrag->free = frag;
+}
+
+/*
+ * Give back the buffers of the datagrams produced for the previous object.
+ */
+static inline void _defrag_release(_defrag_t* defrag)
+{
+    _frag_t* frag;
+
+    while ((frag = defrag->pending)) {
+        defrag->pending = frag->next;
+        frag->next      = defrag->free;
+        defrag->free    = frag;
+    }
+}
+
+/*
+ * Add a fragment to its datagram, returns the datagram if it is now
+ * complete or nil if more fragments are needed or it was dropped.
+ * The protocol of the datagram is taken from the first fragment.
+ */
+static _frag_t* _frag_add(_defrag_t* defrag, const _frag_key_t* key, const core_timespec_t* ts, size_t offset, int more, uint8_t proto, const unsigned char* pkt, size_t len)
+{
+    _frag_t* frag;
+    size_t   hash = _frag_hash(key), end = offset + len, n;
+
+    defrag->stats.fragments++;
+
+    while ((frag = defrag->head)
+           && (ts->sec > frag->ts.sec + (int64_t)defrag->timeout
+               || (ts->sec == frag->ts.sec + (int64_t)defrag->timeout && ts->nsec > frag->ts.nsec))) {
+        defrag->stats.incomplete++;
+        _frag_drop(defrag, frag);
+    }
+
+    if (!len || end > DEFRAG_SIZE || (more && len & 7)) {
+        defrag->stats.dropped++;
+        return 0;
+    }
+
+    for (frag = defrag->bucket[hash & defrag->mask]; frag; frag = frag->hnext) {
+        if (frag->hash == hash && !memcmp(&frag->key, key, sizeof(_frag_key_t))) {
+            break;
+        }
+    }
+
+    if (!frag) {
+        if (!defrag->free) {
+            if (!defrag->head) {
+                /* all buffers are in use by produced datagrams */
+                defrag->stats.dropped++;
+                return 0;
+            }
+            defrag->stats.incomplete++;
+            _frag_drop(defrag, defrag->head);
+        }
+        frag         = defrag->free;
+        defrag->free = frag->next;
+
+        frag->key      = *key;
+        frag->hash     = hash;
+        frag->ts       = *ts;
+        frag->total    = 0;
+        frag->end      = 0;
+        frag->received = 0;
+        memset(frag->bits, 0, DEFRAG_BITS);
+
+        frag->hnext                         = defrag->bucket[hash & defrag->mask];
+        defrag->bucket[hash & defrag->mask] = frag;
+        frag->next                          = 0;
+        frag->prev                          = defrag->tail;
+        if (defrag->tail) {
+            defrag->tail->next = frag;
+        } else {
+            defrag->head = frag;
+        }
+        defrag->tail = frag;
+    }
+
+    /* a fragment past the end, or a second or short last fragment */
+    if ((more && frag->total && end > frag->total)
+        || (!more && (frag->total || frag->end > end))) {
+        defrag->stats.overlapping++;
+        _frag_drop(defrag, frag);
+        return 0;
+    }
+    for (n = offset / 8; n < (end + 7) / 8; n++) {
+        if (frag->bits[n / 8] & (1 << (n & 7))) {
+            defrag->stats.overlapping++;
+            _frag_drop(defrag, frag);
+            return 0;
+        }
+    }
+    for (n = offset / 8; n < (end + 7) / 8; n++) {
+        frag->bits[n / 8] |= 1 << (n & 7);
+    }
+
+    memcpy(frag->buf + offset, pkt, len);
+    frag->received += len;
+    if (!offset) {
+        frag->proto = proto;
+    }
+    if (end > frag->end) {
+        frag->end = end;
+    }
+    if (!more) {
+        frag->total = end;
+    }
+
+    if (!frag->total || frag->received != frag->total) {
+        return 0;
+    }
+
+    defrag->stats.reassembled++;
+    _frag_unlink(defrag, frag);
+    frag->next      = defrag->pending;
+    defrag->pending = frag;
+
+    return frag;
+}
+
+static inline int _ip_defrag(filter_layer_t* self, core_object_ip_t* ip, const unsigned char* pkt)
+{
+    _defrag_t*  defrag = (_defrag_t*)self->defrag;
+    _frag_key_t key;
+    _frag_t*    frag;
+    size_t      offset = (ip->off & 0x1fff) * 8, len = ip->len - (ip->hl * 4);
+
+    /* the reassembled datagram must fit the total length of the header */
+    if (offset + len > 0xffff - (ip->hl * 4)) {
+        defrag->stats.fragments++;
+        defrag->stats.dropped++;
+        return DEFRAG_HELD;
+    }
+
+    memset(&key, 0, sizeof(key));
+    memcpy(key.src, ip->src, 4);
+    memcpy(key.dst, ip->dst, 4);
+    key.id    = ip->id;
+    key.v     = 4;
+    key.proto = ip->p;
+
+    if (!(frag = _frag_add(defrag, &key, &self->packet.pcap->ts, offset, ip->off & 0x2000, ip->p, pkt, len))) {
+        return DEFRAG_HELD;
+    }
+
+    ip->off &= 0x4000;
+    ip->len = (ip->hl * 4) + frag->total;
+
+    return _proto(self, ip->p, (core_object_t*)ip, frag->buf, frag->total);
+}
+
+/*
+ * IPv6 fragments are reassembled from the start of the fragmentable part,
+ * extension headers that were in it are skipped after reassembly.
+ * Atomic fragments (RFC 6946) are not reassembled but parsed as is.
+ */
+static inline int _ip6_defrag(filter_layer_t* self, core_object_ip6_t* ip6, uint8_t nxt, const unsigned char* pkt, size_t len)
+{
+    _defrag_t*  defrag = (_defrag_t*)self->defrag;
+    _frag_key_t key;
+    _frag_t*    frag;
+    size_t      offset = ip6->frag_offlg & 0xfff8, n;
+
+    if (offset || ip6->frag_offlg & 1) {
+        if (offset + len > 0xffff - ip6->hlen) {
+            defrag->stats.fragments++;
+            defrag->stats.dropped++;
+            return DEFRAG_HELD;
+        }
+
+        memset(&key, 0, sizeof(key));
+        memcpy(key.src, ip6->src, 16);
+        memcpy(key.dst, ip6->dst, 16);
+        key.id = ip6->frag_ident;
+        key.v  = 6;
+
+        if (!(frag = _frag_add(defrag, &key, &self->packet.pcap->ts, offset, ip6->frag_offlg & 1, nxt, pkt, len))) {
+            return DEFRAG_HELD;
+        }
+
+        nxt = frag->proto;
+        pkt = frag->buf;
+        len = frag->total;
+    }
+
+    while (nxt == IPPROTO_HOPOPTS || nxt == IPPROTO_DSTOPTS || nxt == IPPROTO_ROUTING) {
+        if (len < 8 || len < (n = (pkt[1] + 1) * 8)) {
+            self->produced = (core_object_t*)ip6;
+            return 0;
+        }
+        nxt = pkt[0];
+        pkt += n;
+        len -= n;
+    }
+
+    ip6->plen = ip6->hlen + len;
+
+    return _proto(self, nxt, (core_object_t*)ip6, pkt, len);
+}
+
 static inline int _ip(filter_layer_t* self, const core_object_t* obj, const unsigned char* pkt, size_t len)
 {
+    self->packet.l3_offset = _offset(self, pkt);
+
     if (len) {
         switch ((*pkt >> 4)) {
         case 4: {
@@ -351,6 +949,10 @@ static inline int _ip(filter_layer_t* self, const core_object_t* obj, const unsi
             if (ip->off & 0x2000 || ip->off & 0x1fff) {
                 core_object_payload_t* payload = &self->payload;
 
+                if (self->defrag) {
+                    return _ip_defrag(self, ip, pkt);
+                }
+
                 payload->obj_prev = (core_object_t*)ip;
 
                 /* Check for padding */
@@ -370,8 +972,10 @@ static inline int _ip(filter_layer_t* self, const core_object_t* obj, const unsi
             return _proto(self, ip->p, (core_object_t*)ip, pkt, len);
         }
         case 6: {
-            core_object_ip6_t* ip6 = &self->ip6;
-            struct ip6_ext     ext;
+            core_object_ip6_t*   ip6 = &self->ip6;
+            struct ip6_ext       ext;
+            const unsigned char* start;
+            uint8_t              frag_nxt = 0;
 
             ip6->obj_prev = obj;
             ip6->is_frag = ip6->have_rtdst = 0;
@@ -383,6 +987,7 @@ static inline int _ip(filter_layer_t* self, const core_object_t* obj, const unsi
             needxb(&ip6->src, 16, pkt, len);
             needxb(&ip6->dst, 16, pkt, len);
             ip6->hlen = 0;
+            start     = pkt;
 
             /* Check reported length for missing payload */
             if (len < ip6->plen) {
@@ -421,6 +1026,12 @@ static inline int _ip(filter_layer_t* self, const core_object_t* obj, const unsi
                     need16(ip6->frag_offlg, pkt, len);
                     need32(ip6->frag_ident, pkt, len);
                     ip6->is_frag = 1;
+
+                    /* the rest is the fragmentable part */
+                    if (self->defrag) {
+                        frag_nxt = ext.ip6e_nxt;
+                        break;
+                    }
                 } else if (ext.ip6e_nxt == IPPROTO_ROUTING) {
                     struct ip6_rthdr rthdr;
 
@@ -451,6 +1062,13 @@ static inline int _ip(filter_layer_t* self, const core_object_t* obj, const unsi
                 }
             }
 
+            if (ip6->is_frag && self->defrag) {
+                if ((size_t)(pkt - start) > ip6->plen) {
+                    break;
+                }
+                return _ip6_defrag(self, ip6, frag_nxt, pkt, ip6->plen - (pkt - start));
+            }
+
             if (ext.ip6e_nxt == IPPROTO_NONE || ip6->is_frag) {
                 core_object_payload_t* payload = &self->payload;
 
@@ -514,6 +1132,50 @@ static inline int _ieee802(filter_layer_t* self, uint16_t tpid, const core_objec
         case ETHERTYPE_IPV6:
             return _ip(self, (core_object_t*)ieee802, pkt, len);
 
+        case 0x8847: /* MPLS unicast */
+        case 0x8848: /* MPLS multicast */
+            if (self->decap) {
+                return _mpls(self, (core_object_t*)ieee802, pkt, len);
+            }
+            break;
+
+        default:
+            break;
+        }
+        break;
+    }
+
+    self->produced = obj;
+
+    return 0;
+}
+
+static inline int _ether(filter_layer_t* self, core_object_ether_t* ether, const core_object_t* obj, const unsigned char* pkt, size_t len)
+{
+    ether->obj_prev = obj;
+
+    for (;;) {
+        needxb(ether->dhost, 6, pkt, len);
+        needxb(ether->shost, 6, pkt, len);
+        need16(ether->type, pkt, len);
+
+        switch (ether->type) {
+        case 0x8100: /* 802.1q */
+        case 0x88a8: /* 802.1ad */
+        case 0x9100: /* 802.1 QinQ non-standard */
+            return _ieee802(self, ether->type, (core_object_t*)ether, pkt, len);
+
+        case ETHERTYPE_IP:
+        case ETHERTYPE_IPV6:
+            return _ip(self, (core_object_t*)ether, pkt, len);
+
+        case 0x8847: /* MPLS unicast */
+        case 0x8848: /* MPLS multicast */
+            if (self->decap) {
+                return _mpls(self, (core_object_t*)ether, pkt, len);
+            }
+            break;
+
         default:
             break;
         }
@@ -530,7 +1192,10 @@ static inline int _link(filter_layer_t* self, const core_object_pcap_t* pcap)
     const unsigned char* pkt;
     size_t               len;
 
-    self->n_ieee802 = 0;
+    self->n_ieee802   = 0;
+    self->tunnel      = 0;
+    self->allowed     = 0;
+    self->packet.pcap = pcap;
 
     pkt = pcap->bytes;
     len = pcap->caplen;
@@ -558,29 +1223,8 @@ static inline int _link(filter_layer_t* self, const core_object_pcap_t* pcap)
         }
         break;
     }
-    case DLT_EN10MB: {
-        core_object_ether_t* ether = &self->ether;
-        ether->obj_prev            = (core_object_t*)pcap;
-
-        needxb(ether->dhost, 6, pkt, len);
-        needxb(ether->shost, 6, pkt, len);
-        need16(ether->type, pkt, len);
-
-        switch (ether->type) {
-        case 0x8100: /* 802.1q */
-        case 0x88a8: /* 802.1ad */
-        case 0x9100: /* 802.1 QinQ non-standard */
-            return _ieee802(self, ether->type, (core_object_t*)ether, pkt, len);
-
-        case ETHERTYPE_IP:
-        case ETHERTYPE_IPV6:
-            return _ip(self, (core_object_t*)ether, pkt, len);
-
-        default:
-            break;
-        }
-        break;
-    }
+    case DLT_EN10MB:
+        return _ether(self, &self->ether, (core_object_t*)pcap, pkt, len);
     case DLT_LOOP: {
         core_object_loop_t* loop = &self->loop;
         loop->obj_prev           = (core_object_t*)pcap;
@@ -672,6 +1316,141 @@ static inline int _link(filter_layer_t* self, const core_object_pcap_t* pcap)
     return 0;
 }
 
+/*
+ * Parse the packet and skip it if only some packets are wanted and it did
+ * not reach an allowed protocol.
+ */
+static inline int _parse(filter_layer_t* self, const core_object_pcap_t* pcap)
+{
+    int ret = _link(self, pcap);
+
+    if (self->only && (ret == SKIPPED || (!ret && !self->allowed))) {
+        return SKIPPED;
+    }
+
+    return ret;
+}
+
+/*
+ * Fill in the packet context from the objects produced and put it at the
+ * top of the chain, this is done once so that receivers don't have to walk
+ * the chain for each lookup.
+ */
+static void _context(filter_layer_t* self)
+{
+    core_object_packet_t* packet = &self->packet;
+    const core_object_t*  obj;
+
+    packet->link       = 0;
+    packet->ip         = 0;
+    packet->transport  = 0;
+    packet->payload    = 0;
+    packet->len        = 0;
+    packet->ts         = packet->pcap->ts;
+    packet->ip_version = 0;
+    packet->proto      = 0;
+    packet->sport      = 0;
+    packet->dport      = 0;
+
+    for (obj = self->produced; obj; obj = obj->obj_prev) {
+        switch (obj->obj_type) {
+        case CORE_OBJECT_ETHER:
+        case CORE_OBJECT_NULL:
+        case CORE_OBJECT_LOOP:
+        case CORE_OBJECT_LINUXSLL:
+        case CORE_OBJECT_LINUXSLL2:
+        case CORE_OBJECT_IEEE802:
+            if (!packet->link) {
+                packet->link = obj;
+            }
+            break;
+        case CORE_OBJECT_IP:
+            if (!packet->ip) {
+                packet->ip         = obj;
+                packet->ip_version = 4;
+                memcpy(packet->src, ((const core_object_ip_t*)obj)->src, 4);
+                memcpy(packet->dst, ((const core_object_ip_t*)obj)->dst, 4);
+                if (!packet->transport) {
+                    packet->proto = ((const core_object_ip_t*)obj)->p;
+                }
+            }
+            break;
+        case CORE_OBJECT_IP6:
+            if (!packet->ip) {
+                packet->ip         = obj;
+                packet->ip_version = 6;
+                memcpy(packet->src, ((const core_object_ip6_t*)obj)->src, 16);
+                memcpy(packet->dst, ((const core_object_ip6_t*)obj)->dst, 16);
+                if (!packet->transport) {
+                    packet->proto = ((const core_object_ip6_t*)obj)->nxt;
+                }
+            }
+            break;
+        case CORE_OBJECT_GRE:
+            if (!packet->transport) {
+                packet->transport = obj;
+                packet->proto     = IPPROTO_GRE;
+            }
+            break;
+        case CORE_OBJECT_ICMP:
+            if (!packet->transport) {
+                packet->transport = obj;
+                packet->proto     = IPPROTO_ICMP;
+            }
+            break;
+        case CORE_OBJECT_ICMP6:
+            if (!packet->transport) {
+                packet->transport = obj;
+                packet->proto     = IPPROTO_ICMPV6;
+            }
+            break;
+        case CORE_OBJECT_UDP:
+            if (!packet->transport) {
+                packet->transport = obj;
+                packet->proto     = IPPROTO_UDP;
+                packet->sport     = ((const core_object_udp_t*)obj)->sport;
+                packet->dport     = ((const core_object_udp_t*)obj)->dport;
+            }
+            break;
+        case CORE_OBJECT_TCP:
+            if (!packet->transport) {
+                packet->transport = obj;
+                packet->proto     = IPPROTO_TCP;
+                packet->sport     = ((const core_object_tcp_t*)obj)->sport;
+                packet->dport     = ((const core_object_tcp_t*)obj)->dport;
+            }
+            break;
+        case CORE_OBJECT_PAYLOAD:
+            if (!packet->payload) {
+                packet->payload = (const core_object_payload_t*)obj;
+                packet->len     = packet->payload->len;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (!packet->ip) {
+        packet->l3_offset = 0;
+        memset(packet->src, 0, sizeof(packet->src));
+        memset(packet->dst, 0, sizeof(packet->dst));
+    }
+    if (!packet->transport) {
+        packet->l4_offset = 0;
+    }
+    if (packet->payload && packet->pcap->bytes
+        && packet->payload->payload >= packet->pcap->bytes
+        && packet->payload->payload < packet->pcap->bytes + packet->pcap->caplen) {
+        packet->payload_offset = packet->payload->payload - packet->pcap->bytes;
+    } else {
+        packet->payload_offset = 0;
+    }
+
+    packet->obj_prev = self->produced;
+    self->produced   = (core_object_t*)packet;
+}
+
 static void _receive(filter_layer_t* self, const core_object_t* obj)
 {
     mlassert_self();
@@ -683,9 +1462,22 @@ static void _receive(filter_layer_t* self, const core_object_t* obj)
     if (obj->obj_type != CORE_OBJECT_PCAP) {
         lfatal("obj is not CORE_OBJECT_PCAP");
     }
+    if (self->defrag) {
+        _defrag_release(self->defrag);
+    }
 
-    if (!_link(self, (core_object_pcap_t*)obj)) {
+    switch (_parse(self, (core_object_pcap_t*)obj)) {
+    case 0:
+        if (self->context) {
+            _context(self);
+        }
         self->recv(self->ctx, self->produced);
+        break;
+    case SKIPPED:
+        self->skipped++;
+        break;
+    default:
+        break;
     }
 }
 
@@ -694,15 +1486,105 @@ core_receiver_t filter_layer_receiver()
     return (core_receiver_t)_receive;
 }
 
+/*
+ * Every object in a batch needs its own set of layer objects, these are
+ * kept in lanes which are filter_layer_t used only for that storage.
+ */
+static void _lanes(filter_layer_t* self, size_t num)
+{
+    size_t n;
+
+    lfatal_oom(self->lanes = realloc(self->lanes, sizeof(filter_layer_t) * num));
+    lfatal_oom(self->batch = realloc(self->batch, sizeof(core_object_t*) * num));
+    for (n = self->lanes_size; n < num; n++) {
+        self->lanes[n]      = _defaults;
+        self->lanes[n]._log = self->_log;
+    }
+    self->lanes_size = num;
+}
+
+static void _receive_batch(filter_layer_t* self, const core_object_t** objs, size_t num)
+{
+    filter_layer_t* lane;
+    size_t          n, out = 0;
+    mlassert_self();
+    lassert(objs, "objs is nil");
+
+    if (!self->recv) {
+        lfatal("no receiver set");
+    }
+    if (num > self->lanes_size) {
+        _lanes(self, num);
+    }
+    if (self->defrag) {
+        _defrag_release(self->defrag);
+    }
+
+    for (n = 0; n < num; n++) {
+        if (objs[n]->obj_type != CORE_OBJECT_PCAP) {
+            lfatal("obj is not CORE_OBJECT_PCAP");
+        }
+        lane          = &self->lanes[n];
+        lane->defrag  = self->defrag;
+        lane->decap   = self->decap;
+        lane->only    = self->only;
+        lane->context = self->context;
+        switch (_parse(lane, (core_object_pcap_t*)objs[n])) {
+        case 0:
+            if (self->context) {
+                _context(lane);
+            }
+            self->batch[out++] = lane->produced;
+            break;
+        case SKIPPED:
+            self->skipped++;
+            break;
+        default:
+            break;
+        }
+    }
+    if (!out) {
+        return;
+    }
+
+    if (self->recv_batch) {
+        self->recv_batch(self->ctx, self->batch, out);
+        return;
+    }
+    for (n = 0; n < out; n++) {
+        self->recv(self->ctx, self->batch[n]);
+    }
+}
+
+core_receiver_batch_t filter_layer_receiver_batch()
+{
+    return (core_receiver_batch_t)_receive_batch;
+}
+
 static const core_object_t* _produce(filter_layer_t* self)
 {
     const core_object_t* obj;
+    int                  ret;
     mlassert_self();
 
-    obj = self->prod(self->prod_ctx);
-    if (!obj || obj->obj_type != CORE_OBJECT_PCAP || _link(self, (core_object_pcap_t*)obj)) {
+    do {
+        if (self->defrag) {
+            _defrag_release(self->defrag);
+        }
+        obj = self->prod(self->prod_ctx);
+        if (!obj || obj->obj_type != CORE_OBJECT_PCAP) {
+            return 0;
+        }
+        if ((ret = _parse(self, (core_object_pcap_t*)obj)) == SKIPPED) {
+            self->skipped++;
+        }
+    } while (ret == DEFRAG_HELD || ret == SKIPPED);
+    if (ret) {
         return 0;
     }
+    if (self->context) {
+        _context(self);
+    }
 
     return self->produced;
 }
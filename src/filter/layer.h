@@ -36,6 +36,7 @@
 #include <dnsjit/core/object/udp.h>
 #include <dnsjit/core/object/tcp.h>
 #include <dnsjit/core/object/payload.h>
+#include <dnsjit/core/object/packet.h>
 
 #ifndef __dnsjit_filter_layer_h
 #define __dnsjit_filter_layer_h
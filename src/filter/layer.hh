@@ -36,6 +36,11 @@
 // lua:require("dnsjit.core.object.udp_h")
 // lua:require("dnsjit.core.object.tcp_h")
 // lua:require("dnsjit.core.object.payload_h")
+// lua:require("dnsjit.core.object.packet_h")
+
+typedef struct filter_layer_defrag_stats {
+    uint64_t fragments, reassembled, incomplete, overlapping, dropped;
+} filter_layer_defrag_stats_t;
 
 typedef struct filter_layer {
     core_log_t      _log;
@@ -61,12 +66,35 @@ typedef struct filter_layer {
     core_object_udp_t       udp;
     core_object_tcp_t       tcp;
     core_object_payload_t   payload;
+    core_object_packet_t    packet;
+    int                     context;
+    void*                   defrag;
+    int                     decap, tunnel;
+    core_object_ether_t     inner_ether;
+    core_object_ip_t        outer_ip;
+    core_object_ip6_t       outer_ip6;
+    core_object_udp_t       outer_udp;
+    core_object_gre_t       outer_gre;
+    void*                   only;
+    int                     allowed;
+    uint64_t                skipped;
+
+    core_receiver_batch_t recv_batch;
+    struct filter_layer*  lanes;
+    size_t                lanes_size;
+    const core_object_t** batch;
 } filter_layer_t;
 
 core_log_t* filter_layer_log();
 
 void filter_layer_init(filter_layer_t* self);
 void filter_layer_destroy(filter_layer_t* self);
+void filter_layer_defrag(filter_layer_t* self, size_t max, size_t timeout);
+void filter_layer_defrag_stats(const filter_layer_t* self, filter_layer_defrag_stats_t* stats);
+void filter_layer_only_proto(filter_layer_t* self, uint8_t proto);
+void filter_layer_only_port(filter_layer_t* self, uint16_t port);
+void filter_layer_only_clear(filter_layer_t* self);
 
-core_receiver_t filter_layer_receiver();
+core_receiver_t       filter_layer_receiver();
+core_receiver_batch_t filter_layer_receiver_batch();
 core_producer_t filter_layer_producer(filter_layer_t* self);
@@ -25,6 +25,52 @@
 -- Objects are chained which each layer in the stack with the top most first.
 -- Currently supports input
 -- .IR dnsjit.core.object.pcap .
+-- .LP
+-- If enabled with
+-- .IR context ()
+-- a
+-- .I dnsjit.core.object.packet
+-- is filled in for each packet and sent as the top most object, it gives
+-- direct access to the layers, offsets, addresses and ports of the packet
+-- so that they can be looked up without walking the chain.
+-- .LP
+-- If enabled with
+-- .IR defrag ()
+-- fragmented IPv4 and IPv6 datagrams are reassembled and produced as if
+-- they had been received unfragmented, the fragments themselves are not
+-- produced.
+-- Datagrams with overlapping fragments are dropped and IPv6 atomic
+-- fragments are parsed as unfragmented packets.
+-- Reassembled datagrams are produced from a buffer of the filter and are
+-- only valid until the next object is received or produced, so they must
+-- be copied if kept.
+-- .LP
+-- If enabled with
+-- .IR decap ()
+-- the payload of GRE, VXLAN (UDP port 4789), GENEVE (UDP port 6081) and MPLS
+-- tunnels is parsed and the inner packet is produced with the tunnel objects
+-- further down the chain, so the top most objects are those of the inner
+-- packet.
+-- Only one level of tunnel is decapsulated.
+-- .LP
+-- If enabled with
+-- .IR only ()
+-- only packets of the allowed protocols and, for UDP and TCP, ports are
+-- produced, parsing of a packet stops as soon as its protocol or ports are
+-- not allowed and the packet is skipped without being sent to the
+-- receiver or returned by the producer, which instead continues with the
+-- next packet.
+-- IP fragments can only be allowed after they have been reassembled with
+-- .IR defrag ().
+-- .LP
+-- Batches of objects can be received and are then sent on as batches if the
+-- receiver supports it, see
+-- .BR dnsjit.core.receiver (3).
+-- .SS Attributes
+-- .TP
+-- skipped
+-- The number of packets skipped because they were not allowed by
+-- .IR only ().
 module(...,package.seeall)
 
 require("dnsjit.filter.layer_h")
@@ -35,6 +81,14 @@ local t_name = "filter_layer_t"
 local filter_layer_t = ffi.typeof(t_name)
 local Layer = {}
 
+local _PROTO = {
+    udp = 17,
+    tcp = 6,
+    icmp = 1,
+    icmp6 = 58,
+    gre = 47,
+}
+
 -- Create a new Layer filter.
 function Layer.new()
     local self = {
@@ -54,14 +108,109 @@ function Layer:log()
     return self.obj._log
 end
 
+-- Enable or disable sending a packet context object on top of the parsed
+-- objects, default disabled.
+function Layer:context(bool)
+    if bool == true then
+        self.obj.context = 1
+    else
+        self.obj.context = 0
+    end
+end
+
+-- Enable or disable decapsulation of GRE, VXLAN, GENEVE and MPLS tunnels,
+-- default disabled.
+function Layer:decap(bool)
+    if bool == true then
+        self.obj.decap = 1
+    else
+        self.obj.decap = 0
+    end
+end
+
+-- Only produce packets of the protocols in the table
+-- .IR protos ,
+-- given as names (udp, tcp, icmp, icmp6, gre) or numbers, default udp and
+-- tcp, and for UDP and TCP only those with a source or destination port in
+-- the table
+-- .IR ports ,
+-- default 53.
+-- An empty
+-- .I ports
+-- table allows any port.
+-- Use
+-- .I ports
+-- false to disable and produce all packets again.
+-- With
+-- .IR decap ()
+-- enabled the tunnels are parsed and it is the inner packet that must be
+-- allowed.
+function Layer:only(ports, protos)
+    C.filter_layer_only_clear(self.obj)
+    if ports == false then
+        return
+    end
+    for _, proto in pairs(protos or { "udp", "tcp" }) do
+        C.filter_layer_only_proto(self.obj, _PROTO[proto] or proto)
+    end
+    for _, port in pairs(ports or { 53 }) do
+        C.filter_layer_only_port(self.obj, port)
+    end
+end
+
+-- Enable reassembly of fragmented IP datagrams with at most
+-- .I max
+-- datagrams, default 64, being reassembled at the same time and
+-- expiring datagrams that have not been completed within
+-- .I timeout
+-- seconds, default 30, of their first fragment as given by the packet
+-- timestamps.
+-- When all datagrams are in use the oldest is dropped to make room.
+-- Memory for all datagrams is allocated when enabled, 65 KiB for each.
+-- Use a
+-- .I max
+-- of 0 to disable.
+function Layer:defrag(max, timeout)
+    C.filter_layer_defrag(self.obj, max or 64, timeout or 30)
+end
+
+-- Return the reassembly counters as an object with the number of
+-- .I fragments
+-- received,
+-- datagrams
+-- .IR reassembled ,
+-- datagrams dropped as
+-- .I incomplete
+-- because they expired or were evicted,
+-- datagrams dropped because of
+-- .I overlapping
+-- or inconsistent fragments and fragments
+-- .I dropped
+-- because they were invalid or too large.
+function Layer:defrag_stats()
+    local stats = ffi.new("filter_layer_defrag_stats_t")
+    C.filter_layer_defrag_stats(self.obj, stats)
+    return stats
+end
+
 -- Return the C functions and context for receiving objects.
 function Layer:receive()
     return C.filter_layer_receiver(), self.obj
 end
 
+-- Return the C functions and context for receiving batches of objects.
+function Layer:receive_batch()
+    return C.filter_layer_receiver_batch(), self.obj
+end
+
 -- Set the receiver to pass objects to.
 function Layer:receiver(o)
     self.obj.recv, self.obj.ctx = o:receive()
+    if o.receive_batch then
+        self.obj.recv_batch = o:receive_batch()
+    else
+        self.obj.recv_batch = nil
+    end
     self._receiver = o
 end
 
@@ -89,5 +238,7 @@ end
 -- dnsjit.core.object.icmp6 (3),
 -- dnsjit.core.object.udp (3),
 -- dnsjit.core.object.tcp (3),
--- dnsjit.core.object.payload (3)
+-- dnsjit.core.object.payload (3),
+-- dnsjit.core.object.packet (3),
+-- dnsjit.core.receiver (3)
 return Layer
@@ -0,0 +1,483 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "filter/match.h"
+#include "core/assert.h"
+#include "core/object/ip.h"
+#include "core/object/ip6.h"
+#include "core/object/udp.h"
+#include "core/object/tcp.h"
+#include "core/object/payload.h"
+#include "core/object/packet.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+/*
+ * The program is a list of instructions that each test one field of the
+ * packet and then jump forward to the instruction given for the result, a
+ * negative jump means no match and a jump to the end of the program means
+ * match.
+ * Since jumps are only forward the program always ends and each
+ * instruction is evaluated at most once per packet.
+ */
+typedef struct _insn {
+    filter_match_op_t op;
+    uint32_t          a, b;
+    int               jt, jf;
+} _insn_t;
+
+typedef struct _prefix {
+    uint8_t v, bits;
+    uint8_t addr[16];
+} _prefix_t;
+
+typedef struct _set {
+    _prefix_t* prefix;
+    size_t     prefixes;
+} _set_t;
+
+typedef struct _prog {
+    _insn_t* insn;
+    size_t   insns;
+    _set_t*  set;
+    size_t   sets;
+} _prog_t;
+
+/*
+ * The fields of the packet the instructions test.
+ */
+typedef struct _fields {
+    uint8_t        v, proto, ports;
+    uint16_t       sport, dport;
+    const uint8_t *src, *dst;
+    const uint8_t* payload;
+    size_t         len;
+} _fields_t;
+
+static core_log_t     _log      = LOG_T_INIT("filter.match");
+static filter_match_t _defaults = {
+    LOG_T_INIT_OBJ("filter.match"),
+    0, 0,
+    0, 0,
+    0, 0,
+    0
+};
+
+core_log_t* filter_match_log()
+{
+    return &_log;
+}
+
+void filter_match_init(filter_match_t* self)
+{
+    mlassert_self();
+
+    *self = _defaults;
+}
+
+void filter_match_destroy(filter_match_t* self)
+{
+    mlassert_self();
+
+    filter_match_clear(self);
+}
+
+void filter_match_clear(filter_match_t* self)
+{
+    _prog_t* prog;
+    size_t   n;
+    mlassert_self();
+
+    if ((prog = self->prog)) {
+        for (n = 0; n < prog->sets; n++) {
+            free(prog->set[n].prefix);
+        }
+        free(prog->set);
+        free(prog->insn);
+        free(prog);
+        self->prog = 0;
+    }
+}
+
+static _prog_t* _prog(filter_match_t* self)
+{
+    if (!self->prog) {
+        lfatal_oom(self->prog = calloc(1, sizeof(_prog_t)));
+    }
+    return self->prog;
+}
+
+int filter_match_insn(filter_match_t* self, filter_match_op_t op, uint32_t a, uint32_t b, int jt, int jf)
+{
+    _prog_t* prog;
+    _insn_t* insn;
+    mlassert_self();
+
+    prog = _prog(self);
+    if ((jt >= 0 && (size_t)jt <= prog->insns) || (jf >= 0 && (size_t)jf <= prog->insns)) {
+        lwarning("instruction %zu does not jump forward", prog->insns);
+        return -1;
+    }
+    if (op > FILTER_MATCH_OP_QTYPE) {
+        lwarning("invalid op %d", op);
+        return -1;
+    }
+
+    lfatal_oom(prog->insn = realloc(prog->insn, (prog->insns + 1) * sizeof(_insn_t)));
+    insn     = &prog->insn[prog->insns++];
+    insn->op = op;
+    insn->a  = a;
+    insn->b  = b;
+    insn->jt = jt;
+    insn->jf = jf;
+
+    return 0;
+}
+
+int filter_match_prefix(filter_match_t* self, uint32_t set, const char* prefix)
+{
+    _prog_t*    prog;
+    _prefix_t*  p;
+    char        addr[INET6_ADDRSTRLEN];
+    const char* slash;
+    size_t      len;
+    long        bits;
+    char*       end;
+    uint8_t     v, max;
+    uint8_t     buf[16];
+    mlassert_self();
+    mlassert(prefix, "prefix is nil");
+
+    if (!(slash = strchr(prefix, '/'))) {
+        slash = prefix + strlen(prefix);
+    }
+    if ((len = slash - prefix) >= sizeof(addr)) {
+        return -1;
+    }
+    memcpy(addr, prefix, len);
+    addr[len] = 0;
+
+    if (inet_pton(AF_INET, addr, buf) == 1) {
+        v   = 4;
+        max = 32;
+    } else if (inet_pton(AF_INET6, addr, buf) == 1) {
+        v   = 6;
+        max = 128;
+    } else {
+        return -1;
+    }
+    bits = max;
+    if (*slash) {
+        bits = strtol(slash + 1, &end, 10);
+        if (end == slash + 1 || *end || bits < 0 || bits > max) {
+            return -1;
+        }
+    }
+
+    prog = _prog(self);
+    if (set >= prog->sets) {
+        lfatal_oom(prog->set = realloc(prog->set, (set + 1) * sizeof(_set_t)));
+        memset(&prog->set[prog->sets], 0, (set + 1 - prog->sets) * sizeof(_set_t));
+        prog->sets = set + 1;
+    }
+    lfatal_oom(prog->set[set].prefix = realloc(prog->set[set].prefix, (prog->set[set].prefixes + 1) * sizeof(_prefix_t)));
+    p       = &prog->set[set].prefix[prog->set[set].prefixes++];
+    p->v    = v;
+    p->bits = bits;
+    memset(p->addr, 0, sizeof(p->addr));
+    memcpy(p->addr, buf, bits / 8);
+    if (bits % 8) {
+        p->addr[bits / 8] = buf[bits / 8] & (0xff << (8 - bits % 8));
+    }
+
+    return 0;
+}
+
+/*
+ * Fill in the fields from the packet context or, if there is none, from
+ * the top most object of each type in the chain.
+ */
+static void _fields(_fields_t* f, const core_object_t* obj)
+{
+    const core_object_payload_t* payload = 0;
+
+    memset(f, 0, sizeof(_fields_t));
+
+    if (obj->obj_type == CORE_OBJECT_PACKET) {
+        const core_object_packet_t* packet = (const core_object_packet_t*)obj;
+
+        f->v     = packet->ip_version;
+        f->proto = packet->proto;
+        f->src   = packet->src;
+        f->dst   = packet->dst;
+        if (packet->transport && (packet->proto == IPPROTO_UDP || packet->proto == IPPROTO_TCP)) {
+            f->ports = 1;
+            f->sport = packet->sport;
+            f->dport = packet->dport;
+        }
+        if ((payload = packet->payload)) {
+            f->payload = payload->payload;
+            f->len     = payload->len;
+        }
+        return;
+    }
+
+    for (; obj; obj = obj->obj_prev) {
+        switch (obj->obj_type) {
+        case CORE_OBJECT_PAYLOAD:
+            if (!payload && !f->ports && !f->v) {
+                payload    = (const core_object_payload_t*)obj;
+                f->payload = payload->payload;
+                f->len     = payload->len;
+            }
+            break;
+        case CORE_OBJECT_UDP:
+            if (!f->ports && !f->v) {
+                f->ports = 1;
+                f->proto = IPPROTO_UDP;
+                f->sport = ((const core_object_udp_t*)obj)->sport;
+                f->dport = ((const core_object_udp_t*)obj)->dport;
+            }
+            break;
+        case CORE_OBJECT_TCP:
+            if (!f->ports && !f->v) {
+                f->ports = 1;
+                f->proto = IPPROTO_TCP;
+                f->sport = ((const core_object_tcp_t*)obj)->sport;
+                f->dport = ((const core_object_tcp_t*)obj)->dport;
+            }
+            break;
+        case CORE_OBJECT_IP:
+            if (!f->v) {
+                f->v   = 4;
+                f->src = ((const core_object_ip_t*)obj)->src;
+                f->dst = ((const core_object_ip_t*)obj)->dst;
+                if (!f->ports) {
+                    f->proto = ((const core_object_ip_t*)obj)->p;
+                }
+            }
+            break;
+        case CORE_OBJECT_IP6:
+            if (!f->v) {
+                f->v   = 6;
+                f->src = ((const core_object_ip6_t*)obj)->src;
+                f->dst = ((const core_object_ip6_t*)obj)->dst;
+                if (!f->ports) {
+                    f->proto = ((const core_object_ip6_t*)obj)->nxt;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static int _in_set(const _set_t* set, uint8_t v, const uint8_t* addr)
+{
+    const _prefix_t* p;
+    size_t           n, bytes;
+
+    if (!addr) {
+        return 0;
+    }
+    for (n = 0; n < set->prefixes; n++) {
+        p = &set->prefix[n];
+        if (p->v != v) {
+            continue;
+        }
+        bytes = p->bits / 8;
+        if (memcmp(p->addr, addr, bytes)) {
+            continue;
+        }
+        if (p->bits % 8 && (addr[bytes] & (0xff << (8 - p->bits % 8))) != p->addr[bytes]) {
+            continue;
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Return the QTYPE of the first question in the DNS message or -1.
+ */
+static int _qtype(const uint8_t* dns, size_t len)
+{
+    size_t at = 12;
+
+    if (len < 12 || !(dns[4] | dns[5])) {
+        return -1;
+    }
+    while (at < len) {
+        if (!dns[at]) {
+            at++;
+            break;
+        }
+        if ((dns[at] & 0xc0) == 0xc0) {
+            at += 2;
+            break;
+        }
+        if (dns[at] & 0xc0) {
+            return -1;
+        }
+        at += dns[at] + 1;
+    }
+    if (at + 2 > len) {
+        return -1;
+    }
+
+    return dns[at] << 8 | dns[at + 1];
+}
+
+static inline int _range(uint32_t v, const _insn_t* insn)
+{
+    return v >= insn->a && v <= insn->b;
+}
+
+static int _run(const _prog_t* prog, const core_object_t* obj)
+{
+    const _insn_t* insn;
+    _fields_t      f;
+    size_t         pc = 0;
+    int            r;
+
+    if (!prog || !prog->insns) {
+        return 1;
+    }
+
+    _fields(&f, obj);
+
+    while (pc < prog->insns) {
+        insn = &prog->insn[pc];
+
+        switch (insn->op) {
+        case FILTER_MATCH_OP_IP:
+            r = f.v == insn->a;
+            break;
+        case FILTER_MATCH_OP_PROTO:
+            r = f.v && f.proto == insn->a;
+            break;
+        case FILTER_MATCH_OP_SPORT:
+            r = f.ports && _range(f.sport, insn);
+            break;
+        case FILTER_MATCH_OP_DPORT:
+            r = f.ports && _range(f.dport, insn);
+            break;
+        case FILTER_MATCH_OP_PORT:
+            r = f.ports && (_range(f.sport, insn) || _range(f.dport, insn));
+            break;
+        case FILTER_MATCH_OP_SRC:
+            r = insn->a < prog->sets && _in_set(&prog->set[insn->a], f.v, f.src);
+            break;
+        case FILTER_MATCH_OP_DST:
+            r = insn->a < prog->sets && _in_set(&prog->set[insn->a], f.v, f.dst);
+            break;
+        case FILTER_MATCH_OP_HOST:
+            r = insn->a < prog->sets && (_in_set(&prog->set[insn->a], f.v, f.src) || _in_set(&prog->set[insn->a], f.v, f.dst));
+            break;
+        case FILTER_MATCH_OP_LEN:
+            r = f.payload && _range(f.len, insn);
+            break;
+        case FILTER_MATCH_OP_QR:
+            r = f.ports && f.len >= 12 && (f.payload[2] >> 7) == insn->a;
+            break;
+        case FILTER_MATCH_OP_OPCODE:
+            r = f.ports && f.len >= 12 && ((f.payload[2] >> 3) & 0xf) == insn->a;
+            break;
+        case FILTER_MATCH_OP_QTYPE:
+            r = f.ports && f.payload && _qtype(f.payload, f.len) == (int)insn->a;
+            break;
+        default:
+            r = 0;
+            break;
+        }
+
+        r = r ? insn->jt : insn->jf;
+        if (r < 0) {
+            return 0;
+        }
+        pc = r;
+    }
+
+    return 1;
+}
+
+int filter_match_run(const filter_match_t* self, const core_object_t* obj)
+{
+    mlassert_self();
+    mlassert(obj, "obj is nil");
+
+    return _run(self->prog, obj);
+}
+
+static void _receive(filter_match_t* self, const core_object_t* obj)
+{
+    mlassert_self();
+    lassert(obj, "obj is nil");
+
+    self->seen++;
+    if (_run(self->prog, obj)) {
+        self->matched++;
+        self->recv(self->ctx, obj);
+    }
+}
+
+core_receiver_t filter_match_receiver(filter_match_t* self)
+{
+    mlassert_self();
+
+    if (!self->recv) {
+        lfatal("no receiver set");
+    }
+
+    return (core_receiver_t)_receive;
+}
+
+static const core_object_t* _produce(filter_match_t* self)
+{
+    const core_object_t* obj;
+    mlassert_self();
+
+    while ((obj = self->prod(self->prod_ctx))) {
+        self->seen++;
+        if (_run(self->prog, obj)) {
+            self->matched++;
+            break;
+        }
+    }
+
+    return obj;
+}
+
+core_producer_t filter_match_producer(filter_match_t* self)
+{
+    mlassert_self();
+
+    if (!self->prod) {
+        lfatal("no producer set");
+    }
+
+    return (core_producer_t)_produce;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// lua:require("dnsjit.core.log")
+// lua:require("dnsjit.core.receiver_h")
+// lua:require("dnsjit.core.producer_h")
+
+typedef enum filter_match_op {
+    FILTER_MATCH_OP_IP,
+    FILTER_MATCH_OP_PROTO,
+    FILTER_MATCH_OP_SPORT,
+    FILTER_MATCH_OP_DPORT,
+    FILTER_MATCH_OP_PORT,
+    FILTER_MATCH_OP_SRC,
+    FILTER_MATCH_OP_DST,
+    FILTER_MATCH_OP_HOST,
+    FILTER_MATCH_OP_LEN,
+    FILTER_MATCH_OP_QR,
+    FILTER_MATCH_OP_OPCODE,
+    FILTER_MATCH_OP_QTYPE
+} filter_match_op_t;
+
+typedef struct filter_match {
+    core_log_t      _log;
+    core_receiver_t recv;
+    void*           ctx;
+
+    core_producer_t prod;
+    void*           prod_ctx;
+
+    uint64_t seen, matched;
+
+    void* prog;
+} filter_match_t;
+
+core_log_t* filter_match_log();
+
+void filter_match_init(filter_match_t* self);
+void filter_match_destroy(filter_match_t* self);
+void filter_match_clear(filter_match_t* self);
+int filter_match_insn(filter_match_t* self, filter_match_op_t op, uint32_t a, uint32_t b, int jt, int jf);
+int filter_match_prefix(filter_match_t* self, uint32_t set, const char* prefix);
+int filter_match_run(const filter_match_t* self, const core_object_t* obj);
+
+core_receiver_t filter_match_receiver(filter_match_t* self);
+core_producer_t filter_match_producer(filter_match_t* self);
@@ -0,0 +1,399 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.filter.match
+-- Pass on only the packets matching an expression
+--   local layer = require("dnsjit.filter.layer").new()
+--   local match = require("dnsjit.filter.match").new()
+--   match:compile("udp and port 53 and query and not qtype ANY")
+--   layer:producer(input)
+--   match:producer(layer)
+--   local prod, pctx = match:produce()
+--
+-- Filter that compiles an expression into a program of tests that is run
+-- in C for each object received or produced, only objects that match are
+-- passed on so the others never reach Lua.
+-- The objects are those from
+-- .BR dnsjit.filter.layer (3),
+-- with or without the packet context, or from
+-- .BR dnsjit.filter.tcpdns (3).
+-- The fields tested are taken from the top most objects of the chain so
+-- for decapsulated packets the inner packet is tested.
+-- .LP
+-- An expression is made of the primitives below combined with
+-- .BR and ,
+-- .BR or ,
+-- .B not
+-- and parentheses,
+-- .B and
+-- binds tighter than
+-- .B or
+-- and each is evaluated from left to right stopping as soon as the result
+-- is known.
+-- An empty expression matches everything.
+-- .TP
+-- .BR ip ", " ip6
+-- The IP version of the packet.
+-- .TP
+-- .BR udp ", " tcp ", " icmp ", " icmp6 ", " gre ", " proto " N"
+-- The IP protocol of the packet.
+-- .TP
+-- .RB [ src | dst "] " port " N[-M]"
+-- The source or destination port, or either, is N or in the range N to M.
+-- .TP
+-- .RB [ src | dst "] " net " PREFIX[,PREFIX...]"
+-- The source or destination address, or either, is in one of the
+-- comma separated IPv4 or IPv6 prefixes, written as an address with an
+-- optional prefix length such as 192.0.2.0/24 or 2001:db8::/32.
+-- .B host
+-- is the same as
+-- .BR net .
+-- .TP
+-- .BR len " [<|<=|>|>=|=] N, " len " N-M"
+-- The length of the payload compared to N or in the range N to M.
+-- .TP
+-- .BR query ", " response
+-- The QR bit of the DNS header in the payload.
+-- .TP
+-- .BR opcode " N|NAME, " qtype " N|NAME"
+-- The OPCODE of the DNS header or the QTYPE of the first question in the
+-- payload, as a number or a name from
+-- .BR dnsjit.core.object.dns (3).
+-- .LP
+-- DNS tests only match UDP and TCP payloads.
+-- They look at the start of the payload so for DNS over TCP the
+-- messages should first be reassembled with
+-- .BR dnsjit.filter.tcpdns (3).
+-- .SS Attributes
+-- .TP
+-- seen
+-- The number of objects tested.
+-- .TP
+-- matched
+-- The number of objects that matched and were passed on.
+module(...,package.seeall)
+
+require("dnsjit.filter.match_h")
+local Dns = require("dnsjit.core.object.dns")
+local ffi = require("ffi")
+local C = ffi.C
+
+local t_name = "filter_match_t"
+local filter_match_t = ffi.typeof(t_name)
+local Match = {}
+
+local _PROTO = {
+    udp = 17,
+    tcp = 6,
+    icmp = 1,
+    icmp6 = 58,
+    gre = 47,
+}
+
+-- Create a new Match filter, optionally compiling the
+-- .IR expression .
+function Match.new(expression)
+    local self = {
+        _receiver = nil,
+        _producer = nil,
+        obj = filter_match_t(),
+    }
+    C.filter_match_init(self.obj)
+    ffi.gc(self.obj, C.filter_match_destroy)
+    self = setmetatable(self, { __index = Match })
+    if expression then
+        self:compile(expression)
+    end
+    return self
+end
+
+-- Return the Log object to control logging of this instance or module.
+function Match:log()
+    if self == nil then
+        return C.filter_match_log()
+    end
+    return self.obj._log
+end
+
+local function _tokens(expression)
+    local tokens = {}
+    local at = 1
+    while true do
+        local s, e, tok = expression:find("^%s*([()])", at)
+        if not s then
+            s, e, tok = expression:find("^%s*([<>]?=?)", at)
+            if tok == "" then
+                s, e, tok = expression:find("^%s*([^%s()<>=]+)", at)
+            end
+        end
+        if not s then
+            break
+        end
+        table.insert(tokens, tok)
+        at = e + 1
+    end
+    if expression:find("%S", at) then
+        error("invalid expression at: " .. expression:sub(at))
+    end
+    return tokens
+end
+
+local function _number(tok, names)
+    if tok == nil then
+        error("missing value")
+    end
+    local n = tonumber(tok)
+    if n == nil and names then
+        n = names[tok:upper()]
+    end
+    if n == nil or n < 0 or n > 65535 or n % 1 ~= 0 then
+        error("invalid value: " .. tok)
+    end
+    return n
+end
+
+local function _range(tok)
+    if tok == nil then
+        error("missing value")
+    end
+    local a, b = tok:match("^(%d+)%-(%d+)$")
+    if a then
+        a, b = _number(a), _number(b)
+        if a > b then
+            error("invalid range: " .. tok)
+        end
+        return a, b
+    end
+    a = _number(tok)
+    return a, a
+end
+
+-- Parse the tokens into a tree of { op, left, right } for and/or/not and
+-- { op, a, b } or { op, prefixes } for the tests.
+local function _parse(tokens)
+    local pos = 1
+    local expr
+
+    local function peek()
+        return tokens[pos]
+    end
+    local function take()
+        pos = pos + 1
+        return tokens[pos - 1]
+    end
+
+    local function primitive()
+        local tok = take()
+        if tok == nil then
+            error("unexpected end of expression")
+        end
+        tok = tok:lower()
+        if tok == "(" then
+            local node = expr()
+            if take() ~= ")" then
+                error("missing )")
+            end
+            return node
+        elseif tok == "not" then
+            return { "not", primitive() }
+        elseif tok == "ip" then
+            return { "FILTER_MATCH_OP_IP", 4, 0 }
+        elseif tok == "ip6" then
+            return { "FILTER_MATCH_OP_IP", 6, 0 }
+        elseif _PROTO[tok] then
+            return { "FILTER_MATCH_OP_PROTO", _PROTO[tok], 0 }
+        elseif tok == "proto" then
+            local p = _number(take())
+            if p > 255 then
+                error("invalid protocol: " .. p)
+            end
+            return { "FILTER_MATCH_OP_PROTO", p, 0 }
+        elseif tok == "query" then
+            return { "FILTER_MATCH_OP_QR", 0, 0 }
+        elseif tok == "response" then
+            return { "FILTER_MATCH_OP_QR", 1, 0 }
+        elseif tok == "opcode" then
+            return { "FILTER_MATCH_OP_OPCODE", _number(take(), Dns.OPCODE), 0 }
+        elseif tok == "qtype" then
+            return { "FILTER_MATCH_OP_QTYPE", _number(take(), Dns.TYPE), 0 }
+        elseif tok == "len" then
+            local cmp = peek()
+            if cmp == "<" or cmp == "<=" or cmp == ">" or cmp == ">=" or cmp == "=" then
+                take()
+                local n = _number(take())
+                if cmp == "<" then
+                    if n == 0 then
+                        return { "FILTER_MATCH_OP_LEN", 1, 0 }
+                    end
+                    return { "FILTER_MATCH_OP_LEN", 0, n - 1 }
+                elseif cmp == "<=" then
+                    return { "FILTER_MATCH_OP_LEN", 0, n }
+                elseif cmp == ">" then
+                    return { "FILTER_MATCH_OP_LEN", n + 1, 4294967295 }
+                elseif cmp == ">=" then
+                    return { "FILTER_MATCH_OP_LEN", n, 4294967295 }
+                end
+                return { "FILTER_MATCH_OP_LEN", n, n }
+            end
+            return { "FILTER_MATCH_OP_LEN", _range(take()) }
+        end
+
+        local dir
+        if tok == "src" or tok == "dst" then
+            dir = tok
+            tok = take()
+        end
+        if tok == "port" then
+            local a, b = _range(take())
+            if dir == "src" then
+                return { "FILTER_MATCH_OP_SPORT", a, b }
+            elseif dir == "dst" then
+                return { "FILTER_MATCH_OP_DPORT", a, b }
+            end
+            return { "FILTER_MATCH_OP_PORT", a, b }
+        elseif tok == "net" or tok == "host" then
+            local list = take()
+            if list == nil then
+                error("missing prefix")
+            end
+            local prefixes = {}
+            for prefix in list:gmatch("[^,]+") do
+                table.insert(prefixes, prefix)
+            end
+            if dir == "src" then
+                return { "FILTER_MATCH_OP_SRC", prefixes = prefixes }
+            elseif dir == "dst" then
+                return { "FILTER_MATCH_OP_DST", prefixes = prefixes }
+            end
+            return { "FILTER_MATCH_OP_HOST", prefixes = prefixes }
+        end
+        error("unknown primitive: " .. tostring(tok))
+    end
+
+    local function conjunction()
+        local node = primitive()
+        while peek() == "and" or peek() == "&&" do
+            take()
+            node = { "and", node, primitive() }
+        end
+        return node
+    end
+
+    expr = function()
+        local node = conjunction()
+        while peek() == "or" or peek() == "||" do
+            take()
+            node = { "or", node, conjunction() }
+        end
+        return node
+    end
+
+    local node = expr()
+    if peek() ~= nil then
+        error("unexpected " .. peek())
+    end
+    return node
+end
+
+-- Generate the instructions for the node jumping to the labels yes and no,
+-- a label gets the index of the instruction it points to when placed.
+local function _generate(prog, node, yes, no)
+    if node[1] == "and" then
+        local mid = {}
+        _generate(prog, node[2], mid, no)
+        mid.pc = #prog
+        _generate(prog, node[3], yes, no)
+    elseif node[1] == "or" then
+        local mid = {}
+        _generate(prog, node[2], yes, mid)
+        mid.pc = #prog
+        _generate(prog, node[3], yes, no)
+    elseif node[1] == "not" then
+        _generate(prog, node[2], no, yes)
+    else
+        table.insert(prog, { node = node, yes = yes, no = no })
+    end
+end
+
+-- Compile the
+-- .I expression
+-- and replace the current program with it, raises an error if the
+-- expression is invalid in which case the current program is kept.
+function Match:compile(expression)
+    local prog = {}
+    local tokens = _tokens(expression)
+    if #tokens > 0 then
+        local yes, no = {}, { pc = -1 }
+        _generate(prog, _parse(tokens), yes, no)
+        yes.pc = #prog
+    end
+
+    -- build the program in a new object and swap it in when complete
+    local obj = filter_match_t()
+    C.filter_match_init(obj)
+    ffi.gc(obj, C.filter_match_destroy)
+    local sets = 0
+    for _, insn in ipairs(prog) do
+        local a, b = insn.node[2], insn.node[3]
+        if insn.node.prefixes then
+            a, b = sets, 0
+            for _, prefix in ipairs(insn.node.prefixes) do
+                if C.filter_match_prefix(obj, sets, prefix) ~= 0 then
+                    error("invalid prefix: " .. prefix)
+                end
+            end
+            sets = sets + 1
+        end
+        if C.filter_match_insn(obj, insn.node[1], a, b, insn.yes.pc, insn.no.pc) ~= 0 then
+            error("invalid instruction")
+        end
+    end
+    self.obj.prog, obj.prog = obj.prog, self.obj.prog
+end
+
+-- Return true if the object matches the current program.
+function Match:match(obj)
+    return C.filter_match_run(self.obj, obj) == 1
+end
+
+-- Return the C functions and context for receiving objects.
+function Match:receive()
+    return C.filter_match_receiver(self.obj), self.obj
+end
+
+-- Set the receiver to pass objects to.
+function Match:receiver(o)
+    self.obj.recv, self.obj.ctx = o:receive()
+    self._receiver = o
+end
+
+-- Return the C functions and context for producing objects.
+function Match:produce()
+    return C.filter_match_producer(self.obj), self.obj
+end
+
+-- Set the producer to get objects from.
+function Match:producer(o)
+    self.obj.prod, self.obj.prod_ctx = o:produce()
+    self._producer = o
+end
+
+-- dnsjit.filter.layer (3),
+-- dnsjit.filter.tcpdns (3),
+-- dnsjit.core.object.dns (3)
+return Match
@@ -26,7 +26,8 @@
 static core_log_t     _log      = LOG_T_INIT("filter.split");
 static filter_split_t _defaults = {
     LOG_T_INIT_OBJ("filter.split"),
-    FILTER_SPLIT_MODE_ROUNDROBIN, 0, 0, 0
+    FILTER_SPLIT_MODE_ROUNDROBIN, 0, 0, 0,
+    0, 0
 };
 
 core_log_t* filter_split_log()
@@ -63,6 +64,7 @@ void filter_split_add(filter_split_t* self, core_receiver_t recv, void* ctx)
     lfatal_oom(r = malloc(sizeof(filter_split_recv_t)));
     r->recv = recv;
     r->ctx  = ctx;
+    self->recvs++;
 
     if (self->recv_last) {
         self->recv_last->next = r;
@@ -85,8 +87,16 @@ static void _roundrobin(filter_split_t* self, const core_object_t* obj)
 static void _sendall(filter_split_t* self, const core_object_t* obj)
 {
     filter_split_recv_t* r;
+    size_t               n;
     mlassert_self();
 
+    if (self->retain) {
+        // the object comes with one reference, add one for each other receiver
+        for (n = 1; n < self->recvs; n++) {
+            core_object_retain((core_object_t*)obj);
+        }
+    }
+
     for (r = self->recv_first; r; r = r->next) {
         r->recv(r->ctx, obj);
         if (r == self->recv_last)
@@ -39,6 +39,8 @@ typedef struct filter_split {
     filter_split_recv_t* recv_first;
     filter_split_recv_t* recv;
     filter_split_recv_t* recv_last;
+    size_t               recvs;
+    int                  retain;
 } filter_split_t;
 
 core_log_t* filter_split_log();
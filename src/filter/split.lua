@@ -25,6 +25,13 @@
 --   input.receiver(filter)
 --
 -- Filter to pass objects to others in various ways.
+-- .LP
+-- When sending copies to all receivers, for example to consumers in other
+-- threads, the copy can be shared instead of copied for each receiver by
+-- enabling
+-- .IR retain ()
+-- and having every receiver release the object when done, see
+-- .BR dnsjit.core.object (3).
 module(...,package.seeall)
 
 require("dnsjit.filter.split_h")
@@ -64,6 +71,17 @@ function Split:sendall()
     self.obj.mode = "FILTER_SPLIT_MODE_SENDALL"
 end
 
+-- Enable or disable adding a reference to the object for each additional
+-- receiver when sending to all receivers, the objects received must be
+-- copies.
+function Split:retain(bool)
+    if bool == true then
+        self.obj.retain = 1
+    else
+        self.obj.retain = 0
+    end
+end
+
 -- Return the C functions and context for receiving objects.
 function Split:receive()
     return C.filter_split_receiver(self.obj), self.obj
@@ -77,4 +95,5 @@ function Split:receiver(o)
     table.insert(self.receivers, o)
 end
 
+-- dnsjit.core.object (3)
 return Split
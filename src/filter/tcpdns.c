@@ -0,0 +1,537 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "filter/tcpdns.h"
+#include "core/assert.h"
+#include "core/object/pcap.h"
+#include "core/object/ip.h"
+#include "core/object/ip6.h"
+#include "core/object/tcp.h"
+#include "core/object/packet.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Flows are kept in a fixed size table, found by a hash of the key and
+ * also kept in order of last activity so that idle flows can be evicted.
+ * Each flow has a buffer, allocated on first use and then reused, which
+ * holds the stream from the start of the first incomplete DNS message.
+ * Segments received out of order are placed in the buffer where they
+ * belong and tracked as ranges until the gap before them is filled, so
+ * the reorder window is the space left in the buffer.
+ */
+#define N_RANGES 8
+
+#define TCP_FIN 0x01
+#define TCP_SYN 0x02
+#define TCP_RST 0x04
+
+typedef struct _flow_key {
+    uint8_t  src[16], dst[16];
+    uint16_t sport, dport;
+    uint8_t  v;
+} _flow_key_t;
+
+typedef struct _flow {
+    struct _flow *  hnext, *prev, *next;
+    _flow_key_t     key;
+    size_t          hash;
+    core_timespec_t ts;
+    uint32_t        seq;
+    size_t          start, have, ranges;
+    struct {
+        size_t start, end;
+    } range[N_RANGES];
+    uint8_t* buf;
+} _flow_t;
+
+typedef struct _state {
+    size_t    max_flows, buffer_size;
+    size_t    mask;
+    _flow_t** bucket;
+    _flow_t*  flows;
+    _flow_t * free, *head, *tail;
+    _flow_t*  current;
+    int       close;
+} _state_t;
+
+static core_log_t      _log      = LOG_T_INIT("filter.tcpdns");
+static filter_tcpdns_t _defaults = {
+    LOG_T_INIT_OBJ("filter.tcpdns"),
+    0, 0,
+    0, 0,
+    256, 131072, 60,
+    0, 0, 0, 0, 0,
+    CORE_OBJECT_PAYLOAD_INIT(0),
+    0
+};
+
+core_log_t* filter_tcpdns_log()
+{
+    return &_log;
+}
+
+void filter_tcpdns_init(filter_tcpdns_t* self)
+{
+    mlassert_self();
+
+    *self = _defaults;
+}
+
+void filter_tcpdns_destroy(filter_tcpdns_t* self)
+{
+    _state_t* state;
+    size_t    n;
+    mlassert_self();
+
+    if ((state = self->state)) {
+        for (n = 0; n < state->max_flows; n++) {
+            free(state->flows[n].buf);
+        }
+        free(state->flows);
+        free(state->bucket);
+        free(state);
+    }
+}
+
+static _state_t* _state(filter_tcpdns_t* self)
+{
+    _state_t* state;
+    size_t    n, buckets = 1;
+
+    if (!self->max_flows || self->buffer_size < 2) {
+        lfatal("invalid max flows or buffer size");
+    }
+    while (buckets < self->max_flows * 2) {
+        buckets <<= 1;
+    }
+
+    lfatal_oom(state = calloc(1, sizeof(_state_t)));
+    lfatal_oom(state->bucket = calloc(buckets, sizeof(_flow_t*)));
+    lfatal_oom(state->flows = calloc(self->max_flows, sizeof(_flow_t)));
+    state->max_flows   = self->max_flows;
+    state->buffer_size = self->buffer_size;
+    state->mask        = buckets - 1;
+    for (n = state->max_flows; n; n--) {
+        state->flows[n - 1].next = state->free;
+        state->free              = &state->flows[n - 1];
+    }
+
+    self->state = state;
+    return state;
+}
+
+static inline size_t _hash(const _flow_key_t* key)
+{
+    const uint8_t* p = (const uint8_t*)key;
+    uint32_t       h = 2166136261u;
+    size_t         n;
+
+    for (n = 0; n < sizeof(_flow_key_t); n++) {
+        h = (h ^ p[n]) * 16777619u;
+    }
+
+    return h;
+}
+
+static void _unlink(_state_t* state, _flow_t* flow)
+{
+    if (flow->prev) {
+        flow->prev->next = flow->next;
+    } else {
+        state->head = flow->next;
+    }
+    if (flow->next) {
+        flow->next->prev = flow->prev;
+    } else {
+        state->tail = flow->prev;
+    }
+}
+
+static void _append(_state_t* state, _flow_t* flow)
+{
+    flow->next = 0;
+    flow->prev = state->tail;
+    if (state->tail) {
+        state->tail->next = flow;
+    } else {
+        state->head = flow;
+    }
+    state->tail = flow;
+}
+
+static void _drop(_state_t* state, _flow_t* flow)
+{
+    _flow_t** p = &state->bucket[flow->hash & state->mask];
+
+    while (*p != flow) {
+        p = &(*p)->hnext;
+    }
+    *p = flow->hnext;
+    _unlink(state, flow);
+
+    if (state->current == flow) {
+        state->current = 0;
+    }
+    flow->next  = state->free;
+    state->free = flow;
+}
+
+static void _reset(_flow_t* flow, uint32_t seq)
+{
+    flow->seq    = seq;
+    flow->start  = 0;
+    flow->have   = 0;
+    flow->ranges = 0;
+}
+
+/*
+ * Move the unconsumed part of the stream to the start of the buffer.
+ */
+static void _compact(_flow_t* flow)
+{
+    size_t end = flow->have, n;
+
+    if (!flow->start) {
+        return;
+    }
+    for (n = 0; n < flow->ranges; n++) {
+        if (flow->range[n].end > end) {
+            end = flow->range[n].end;
+        }
+    }
+    memmove(flow->buf, flow->buf + flow->start, end - flow->start);
+    for (n = 0; n < flow->ranges; n++) {
+        flow->range[n].start -= flow->start;
+        flow->range[n].end -= flow->start;
+    }
+    flow->have -= flow->start;
+    flow->start = 0;
+}
+
+/*
+ * Add an out of order range, merging it with those it overlaps or
+ * touches, returns non-zero if there are too many ranges.
+ */
+static int _range(_flow_t* flow, size_t start, size_t end)
+{
+    size_t n = 0;
+
+    while (n < flow->ranges) {
+        if (start <= flow->range[n].end && end >= flow->range[n].start) {
+            if (flow->range[n].start < start) {
+                start = flow->range[n].start;
+            }
+            if (flow->range[n].end > end) {
+                end = flow->range[n].end;
+            }
+            flow->range[n] = flow->range[--flow->ranges];
+            n              = 0;
+            continue;
+        }
+        n++;
+    }
+    if (flow->ranges == N_RANGES) {
+        return 1;
+    }
+    flow->range[flow->ranges].start = start;
+    flow->range[flow->ranges].end   = end;
+    flow->ranges++;
+
+    return 0;
+}
+
+/*
+ * Extend the in order part of the stream with ranges that now follow it.
+ */
+static void _advance(_flow_t* flow)
+{
+    size_t n = 0;
+
+    while (n < flow->ranges) {
+        if (flow->range[n].start <= flow->have) {
+            if (flow->range[n].end > flow->have) {
+                flow->seq += flow->range[n].end - flow->have;
+                flow->have = flow->range[n].end;
+            }
+            flow->range[n] = flow->range[--flow->ranges];
+            n              = 0;
+            continue;
+        }
+        n++;
+    }
+}
+
+static const core_object_payload_t* _find(const core_object_t* obj, const core_timespec_t** ts)
+{
+    const core_object_payload_t* payload = 0;
+
+    *ts = 0;
+    if (obj->obj_type == CORE_OBJECT_PACKET) {
+        *ts = &((const core_object_packet_t*)obj)->ts;
+        return ((const core_object_packet_t*)obj)->payload;
+    }
+    if (obj->obj_type == CORE_OBJECT_PAYLOAD) {
+        payload = (const core_object_payload_t*)obj;
+    }
+    for (; obj; obj = obj->obj_prev) {
+        if (obj->obj_type == CORE_OBJECT_PCAP) {
+            *ts = &((const core_object_pcap_t*)obj)->ts;
+            break;
+        }
+    }
+
+    return payload;
+}
+
+/*
+ * Add the segment to its flow and make it the current flow, returns
+ * non-zero if the object is not a TCP segment.
+ */
+static int _segment(filter_tcpdns_t* self, const core_object_t* obj)
+{
+    _state_t*                    state = self->state;
+    const core_object_payload_t* payload;
+    const core_object_tcp_t*     tcp;
+    const core_object_t*         ip;
+    const core_timespec_t*       ts;
+    const uint8_t*               data;
+    _flow_key_t                  key;
+    _flow_t*                     flow;
+    size_t                       hash, len, pos;
+    int32_t                      rel;
+
+    if (!(payload = _find(obj, &ts)) || !payload->obj_prev || payload->obj_prev->obj_type != CORE_OBJECT_TCP) {
+        return 1;
+    }
+    tcp                    = (const core_object_tcp_t*)payload->obj_prev;
+    self->payload.obj_prev = (core_object_t*)tcp;
+
+    if (!state) {
+        state = _state(self);
+    }
+    if (state->close && state->current) {
+        _drop(state, state->current);
+    }
+    state->current = 0;
+    state->close   = 0;
+
+    memset(&key, 0, sizeof(key));
+    for (ip = tcp->obj_prev; ip; ip = ip->obj_prev) {
+        if (ip->obj_type == CORE_OBJECT_IP) {
+            memcpy(key.src, ((const core_object_ip_t*)ip)->src, 4);
+            memcpy(key.dst, ((const core_object_ip_t*)ip)->dst, 4);
+            key.v = 4;
+            break;
+        }
+        if (ip->obj_type == CORE_OBJECT_IP6) {
+            memcpy(key.src, ((const core_object_ip6_t*)ip)->src, 16);
+            memcpy(key.dst, ((const core_object_ip6_t*)ip)->dst, 16);
+            key.v = 6;
+            break;
+        }
+    }
+    key.sport = tcp->sport;
+    key.dport = tcp->dport;
+    hash      = _hash(&key);
+
+    self->segments++;
+
+    /* evict idle flows */
+    while (ts && (flow = state->head)
+           && (ts->sec > flow->ts.sec + (int64_t)self->timeout
+               || (ts->sec == flow->ts.sec + (int64_t)self->timeout && ts->nsec > flow->ts.nsec))) {
+        self->evicted++;
+        _drop(state, flow);
+    }
+
+    for (flow = state->bucket[hash & state->mask]; flow; flow = flow->hnext) {
+        if (flow->hash == hash && !memcmp(&flow->key, &key, sizeof(_flow_key_t))) {
+            break;
+        }
+    }
+
+    data = payload->payload;
+    len  = payload->len;
+
+    if (!flow) {
+        if (!len && (!(tcp->flags & TCP_SYN) || tcp->flags & (TCP_FIN | TCP_RST))) {
+            return 0;
+        }
+        if (!state->free) {
+            self->evicted++;
+            _drop(state, state->head);
+        }
+        flow        = state->free;
+        state->free = flow->next;
+        if (!flow->buf) {
+            lfatal_oom(flow->buf = malloc(state->buffer_size));
+        }
+        flow->key   = key;
+        flow->hash  = hash;
+        flow->hnext = state->bucket[hash & state->mask];
+
+        state->bucket[hash & state->mask] = flow;
+        _append(state, flow);
+        self->flows++;
+
+        /* without SYN assume the segment starts a DNS message */
+        _reset(flow, tcp->flags & TCP_SYN ? tcp->seq + 1 : tcp->seq);
+    } else {
+        if (tcp->flags & TCP_SYN) {
+            _reset(flow, tcp->seq + 1);
+        }
+        _unlink(state, flow);
+        _append(state, flow);
+    }
+    if (ts) {
+        flow->ts = *ts;
+    }
+    state->current = flow;
+    if (tcp->flags & (TCP_FIN | TCP_RST)) {
+        state->close = 1;
+    }
+
+    if (!len) {
+        return 0;
+    }
+    if (tcp->flags & TCP_SYN) {
+        /* data in SYN (TFO) starts at the sequence after SYN */
+        rel = 0;
+    } else {
+        rel = (int32_t)(tcp->seq - flow->seq);
+    }
+
+    /* trim what has already been received */
+    if (rel < 0) {
+        if ((size_t)-rel >= len) {
+            return 0;
+        }
+        data += -rel;
+        len -= -rel;
+        rel = 0;
+    }
+
+    _compact(flow);
+    pos = flow->have + rel;
+    if (pos > state->buffer_size || len > state->buffer_size - pos) {
+        self->dropped++;
+        if (!rel) {
+            /* a message larger than the buffer, the stream can not be followed */
+            state->close = 1;
+        }
+        return 0;
+    }
+    memcpy(flow->buf + pos, data, len);
+
+    if (rel) {
+        if (_range(flow, pos, pos + len)) {
+            self->dropped++;
+        }
+        return 0;
+    }
+    flow->have += len;
+    flow->seq += len;
+    _advance(flow);
+
+    return 0;
+}
+
+/*
+ * Set the payload to the next complete DNS message of the current flow,
+ * returns non-zero if there is none.
+ */
+static int _message(filter_tcpdns_t* self)
+{
+    _state_t* state = self->state;
+    _flow_t*  flow;
+    size_t    len;
+
+    while (state && (flow = state->current) && flow->have - flow->start >= 2) {
+        len = (flow->buf[flow->start] << 8) | flow->buf[flow->start + 1];
+        if (flow->have - flow->start - 2 < len) {
+            break;
+        }
+        self->payload.payload = flow->buf + flow->start + 2;
+        self->payload.len     = len;
+        flow->start += 2 + len;
+        if (!len) {
+            continue;
+        }
+        self->messages++;
+        return 0;
+    }
+
+    return 1;
+}
+
+static void _receive(filter_tcpdns_t* self, const core_object_t* obj)
+{
+    mlassert_self();
+    lassert(obj, "obj is nil");
+
+    if (_segment(self, obj)) {
+        self->recv(self->ctx, obj);
+        return;
+    }
+    while (!_message(self)) {
+        self->recv(self->ctx, (core_object_t*)&self->payload);
+    }
+}
+
+core_receiver_t filter_tcpdns_receiver(filter_tcpdns_t* self)
+{
+    mlassert_self();
+
+    if (!self->recv) {
+        lfatal("no receiver set");
+    }
+
+    return (core_receiver_t)_receive;
+}
+
+static const core_object_t* _produce(filter_tcpdns_t* self)
+{
+    const core_object_t* obj;
+    mlassert_self();
+
+    while (_message(self)) {
+        obj = self->prod(self->prod_ctx);
+        if (!obj || _segment(self, obj)) {
+            return obj;
+        }
+    }
+
+    return (core_object_t*)&self->payload;
+}
+
+core_producer_t filter_tcpdns_producer(filter_tcpdns_t* self)
+{
+    mlassert_self();
+
+    if (!self->prod) {
+        lfatal("no producer set");
+    }
+
+    return (core_producer_t)_produce;
+}
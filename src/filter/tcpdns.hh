@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 OARC, Inc.
+ * All rights reserved.
+ *
+ * This file is part of dnsjit.
+ *
+ * dnsjit is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dnsjit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// lua:require("dnsjit.core.log")
+// lua:require("dnsjit.core.receiver_h")
+// lua:require("dnsjit.core.producer_h")
+// lua:require("dnsjit.core.object.payload_h")
+
+typedef struct filter_tcpdns {
+    core_log_t      _log;
+    core_receiver_t recv;
+    void*           ctx;
+
+    core_producer_t prod;
+    void*           prod_ctx;
+
+    size_t max_flows, buffer_size, timeout;
+
+    uint64_t segments, messages, flows, evicted, dropped;
+
+    core_object_payload_t payload;
+    void*                 state;
+} filter_tcpdns_t;
+
+core_log_t* filter_tcpdns_log();
+
+void filter_tcpdns_init(filter_tcpdns_t* self);
+void filter_tcpdns_destroy(filter_tcpdns_t* self);
+
+core_receiver_t filter_tcpdns_receiver(filter_tcpdns_t* self);
+core_producer_t filter_tcpdns_producer(filter_tcpdns_t* self);
@@ -0,0 +1,147 @@
+-- Copyright (c) 2025 OARC, Inc.
+-- All rights reserved.
+--
+-- This file is part of dnsjit.
+--
+-- dnsjit is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- dnsjit is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
+
+-- dnsjit.filter.tcpdns
+-- Reassemble DNS messages from TCP streams
+--   local layer = require("dnsjit.filter.layer").new()
+--   local tcpdns = require("dnsjit.filter.tcpdns").new()
+--   layer:producer(input)
+--   tcpdns:producer(layer)
+--   local prod, pctx = tcpdns:produce()
+--
+-- Filter that follows the TCP streams of the segments it receives and sends
+-- each complete DNS message as its own payload object, without the 2 byte
+-- length, chained to the TCP object of the segment that completed it.
+-- Objects that are not payloads of TCP segments are passed through as is
+-- so UDP DNS can be handled by the same receivers.
+-- It takes the objects from
+-- .BR dnsjit.filter.layer (3)
+-- with or without the packet context.
+-- .LP
+-- Each direction of a connection is a flow and the flows are kept in a
+-- table with a fixed number of entries.
+-- A flow is started by a SYN or, if that was not seen, by the first
+-- segment with data which is then assumed to start with a DNS message.
+-- Segments are ordered by their sequence number, data already received is
+-- skipped and segments received out of order are held until the gap
+-- before them is filled as long as they fit into the buffer of the flow,
+-- which therefore is the reorder window.
+-- A flow is removed after a FIN or RST, when it has been idle for the
+-- timeout, as given by the packet timestamps, or when the table is full
+-- and it is the least recently active flow.
+-- .LP
+-- The payload objects point into the buffer of the flow and are only valid
+-- until the next object is received or produced, so they must be copied if
+-- kept.
+-- .SS Attributes
+-- .TP
+-- segments
+-- The number of TCP segments received.
+-- .TP
+-- messages
+-- The number of DNS messages sent.
+-- .TP
+-- flows
+-- The number of flows started.
+-- .TP
+-- evicted
+-- The number of flows removed because they were idle or the table was
+-- full.
+-- .TP
+-- dropped
+-- The number of segments dropped because they did not fit into the buffer
+-- or there were too many out of order segments.
+module(...,package.seeall)
+
+require("dnsjit.filter.tcpdns_h")
+local ffi = require("ffi")
+local C = ffi.C
+
+local t_name = "filter_tcpdns_t"
+local filter_tcpdns_t = ffi.typeof(t_name)
+local Tcpdns = {}
+
+-- Create a new Tcpdns filter.
+function Tcpdns.new()
+    local self = {
+        _receiver = nil,
+        _producer = nil,
+        obj = filter_tcpdns_t(),
+    }
+    C.filter_tcpdns_init(self.obj)
+    ffi.gc(self.obj, C.filter_tcpdns_destroy)
+    return setmetatable(self, { __index = Tcpdns })
+end
+
+-- Return the Log object to control logging of this instance or module.
+function Tcpdns:log()
+    if self == nil then
+        return C.filter_tcpdns_log()
+    end
+    return self.obj._log
+end
+
+-- Set the maximum number of flows, default 256.
+-- Must be set before any object is received or produced, later changes
+-- have no effect.
+function Tcpdns:max_flows(max)
+    self.obj.max_flows = max
+end
+
+-- Set the size of the buffer for each flow, default 131072 which holds the
+-- largest DNS message.
+-- The buffer of a flow is allocated when it is first used and kept, so the
+-- memory used is at most the maximum number of flows times this size.
+-- Must be set before any object is received or produced, later changes
+-- have no effect.
+function Tcpdns:buffer_size(size)
+    self.obj.buffer_size = size
+end
+
+-- Set the number of seconds after which an idle flow is removed,
+-- default 60.
+function Tcpdns:timeout(seconds)
+    self.obj.timeout = seconds
+end
+
+-- Return the C functions and context for receiving objects.
+function Tcpdns:receive()
+    return C.filter_tcpdns_receiver(self.obj), self.obj
+end
+
+-- Set the receiver to pass objects to.
+function Tcpdns:receiver(o)
+    self.obj.recv, self.obj.ctx = o:receive()
+    self._receiver = o
+end
+
+-- Return the C functions and context for producing objects.
+function Tcpdns:produce()
+    return C.filter_tcpdns_producer(self.obj), self.obj
+end
+
+-- Set the producer to get objects from.
+function Tcpdns:producer(o)
+    self.obj.prod, self.obj.prod_ctx = o:produce()
+    self._producer = o
+end
+
+-- dnsjit.filter.layer (3),
+-- dnsjit.core.object.payload (3),
+-- dnsjit.core.object.tcp (3)
+return Tcpdns
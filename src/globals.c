@@ -58,3 +58,16 @@ void dnsjit_globals(lua_State* L)
 #endif
     lua_setglobal(L, "DNSJIT_URL");
 }
+
+lua_State* dnsjit_newstate(void)
+{
+    lua_State* L;
+
+    if (!(L = luaL_newstate())) {
+        return 0;
+    }
+    luaL_openlibs(L);
+    dnsjit_globals(L);
+
+    return L;
+}
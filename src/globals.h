@@ -23,6 +23,7 @@
 
 #include <lua.h>
 
-void dnsjit_globals(lua_State* L);
+void       dnsjit_globals(lua_State* L);
+lua_State* dnsjit_newstate(void);
 
 #endif
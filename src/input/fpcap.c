@@ -63,7 +63,8 @@ static input_fpcap_t _defaults = {
     CORE_OBJECT_PCAP_INIT(0),
     0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0,
-    0
+    0,
+    0, 64, 0, 0, 0, 0
 };
 
 core_log_t* input_fpcap_log()
@@ -86,6 +87,9 @@ void input_fpcap_destroy(input_fpcap_t* self)
         fclose(self->file);
     }
     free(self->buf);
+    free(self->batch_pkts);
+    free(self->batch);
+    free(self->batch_buf);
 }
 
 static int _open(input_fpcap_t* self)
@@ -221,6 +225,105 @@ int input_fpcap_openfp(input_fpcap_t* self, void* fp)
     return _open(self);
 }
 
+static void _batch_init(input_fpcap_t* self)
+{
+    core_object_pcap_t pkt = CORE_OBJECT_PCAP_INIT(0);
+    size_t             n;
+
+    if (self->batch) {
+        return;
+    }
+    if (!self->batch_size) {
+        self->batch_size = 1;
+    }
+
+    pkt.snaplen    = self->snaplen;
+    pkt.linktype   = self->linktype;
+    pkt.is_swapped = self->is_swapped;
+
+    lfatal_oom(self->batch_pkts = malloc(sizeof(core_object_pcap_t) * self->batch_size));
+    lfatal_oom(self->batch = malloc(sizeof(core_object_t*) * self->batch_size));
+    for (n = 0; n < self->batch_size; n++) {
+        self->batch_pkts[n] = pkt;
+        self->batch[n]      = (core_object_t*)&self->batch_pkts[n];
+    }
+
+    // room for a batch of common sized packets but always for one full snaplen
+    self->batch_buf_size = self->batch_size * 2048;
+    if (self->batch_buf_size < self->snaplen) {
+        self->batch_buf_size = self->snaplen;
+    }
+    lfatal_oom(self->batch_buf = malloc(self->batch_buf_size));
+}
+
+static int _run_batch(input_fpcap_t* self)
+{
+    struct {
+        uint32_t ts_sec;
+        uint32_t ts_usec;
+        uint32_t incl_len;
+        uint32_t orig_len;
+    } hdr;
+    core_object_pcap_t* pkt;
+    size_t              n = 0, at = 0;
+    int                 ret, err = 0;
+
+    _batch_init(self);
+
+    while ((ret = fread(&hdr, 1, 16, self->file)) == 16) {
+        if (self->is_swapped) {
+            hdr.ts_sec   = bswap_32(hdr.ts_sec);
+            hdr.ts_usec  = bswap_32(hdr.ts_usec);
+            hdr.incl_len = bswap_32(hdr.incl_len);
+            hdr.orig_len = bswap_32(hdr.orig_len);
+        }
+        if (hdr.incl_len > self->snaplen) {
+            lwarning("invalid packet length, larger then snaplen");
+            err = -1;
+            break;
+        }
+        if (n == self->batch_size || self->batch_buf_size - at < hdr.incl_len) {
+            self->recv_batch(self->ctx, self->batch, n);
+            n  = 0;
+            at = 0;
+        }
+
+        pkt        = &self->batch_pkts[n];
+        pkt->bytes = self->batch_buf + at;
+        if (fread((void*)pkt->bytes, 1, hdr.incl_len, self->file) != hdr.incl_len) {
+            lwarning("could not read all of packet, aborting");
+            err = -1;
+            break;
+        }
+
+        self->pkts++;
+
+        pkt->ts.sec = hdr.ts_sec;
+        if (self->is_nanosec) {
+            pkt->ts.nsec = hdr.ts_usec;
+        } else {
+            pkt->ts.nsec = hdr.ts_usec * 1000;
+        }
+        pkt->caplen = hdr.incl_len;
+        pkt->len    = hdr.orig_len;
+
+        n++;
+        at += hdr.incl_len;
+    }
+    if (n) {
+        self->recv_batch(self->ctx, self->batch, n);
+    }
+    if (err) {
+        return err;
+    }
+    if (ret) {
+        lwarning("could not read next PCAP header, aborting");
+        return -1;
+    }
+
+    return 0;
+}
+
 int input_fpcap_run(input_fpcap_t* self)
 {
     struct {
@@ -239,6 +342,9 @@ int input_fpcap_run(input_fpcap_t* self)
     if (!self->recv) {
         lfatal("no receiver set");
     }
+    if (self->recv_batch) {
+        return _run_batch(self);
+    }
 
     pkt.snaplen    = self->snaplen;
     pkt.linktype   = self->linktype;
@@ -28,6 +28,13 @@
 -- and parse the PCAP without libpcap.
 -- After opening a file and reading the PCAP header, the attributes are
 -- populated.
+-- .LP
+-- If the receiver has a batch receiver (see
+-- .BR dnsjit.core.receiver (3))
+-- then
+-- .IR run ()
+-- sends the packets in batches, see
+-- .IR batch ().
 -- .SS Attributes
 -- .TP
 -- is_swapped
@@ -92,9 +99,21 @@ end
 -- Set the receiver to pass objects to.
 function Fpcap:receiver(o)
     self.obj.recv, self.obj.ctx = o:receive()
+    if o.receive_batch then
+        self.obj.recv_batch = o:receive_batch()
+    else
+        self.obj.recv_batch = nil
+    end
     self._receiver = o
 end
 
+-- Set the maximum number of packets to send in each batch, default 64.
+-- Must be set before calling
+-- .IR run ().
+function Fpcap:batch(size)
+    self.obj.batch_size = size
+end
+
 -- Return the C functions and context for producing objects.
 function Fpcap:produce()
     return C.input_fpcap_producer(self.obj), self.obj
@@ -65,7 +65,8 @@ static input_mmpcap_t _defaults = {
     CORE_OBJECT_PCAP_INIT(0),
     -1, 0, 0, 0, MAP_FAILED,
     0, 0, 0, 0, 0, 0, 0,
-    0
+    0,
+    0, 64, 0, 0
 };
 
 core_log_t* input_mmpcap_log()
@@ -90,6 +91,8 @@ void input_mmpcap_destroy(input_mmpcap_t* self)
     if (self->fd > -1) {
         close(self->fd);
     }
+    free(self->batch_pkts);
+    free(self->batch);
 }
 
 int input_mmpcap_open(input_mmpcap_t* self, const char* file)
@@ -201,6 +204,91 @@ int input_mmpcap_open(input_mmpcap_t* self, const char* file)
     return 0;
 }
 
+static int _run_batch(input_mmpcap_t* self)
+{
+    struct {
+        uint32_t ts_sec;
+        uint32_t ts_usec;
+        uint32_t incl_len;
+        uint32_t orig_len;
+    } hdr;
+    core_object_pcap_t  pkt = CORE_OBJECT_PCAP_INIT(0);
+    core_object_pcap_t* p;
+    size_t              n = 0;
+    int                 err = 0;
+
+    if (!self->batch) {
+        if (!self->batch_size) {
+            self->batch_size = 1;
+        }
+        pkt.snaplen    = self->snaplen;
+        pkt.linktype   = self->linktype;
+        pkt.is_swapped = self->is_swapped;
+
+        lfatal_oom(self->batch_pkts = malloc(sizeof(core_object_pcap_t) * self->batch_size));
+        lfatal_oom(self->batch = malloc(sizeof(core_object_t*) * self->batch_size));
+        for (n = 0; n < self->batch_size; n++) {
+            self->batch_pkts[n] = pkt;
+            self->batch[n]      = (core_object_t*)&self->batch_pkts[n];
+        }
+        n = 0;
+    }
+
+    while (self->len - self->at > 16) {
+        memcpy(&hdr, &self->buf[self->at], 16);
+        if (self->is_swapped) {
+            hdr.ts_sec   = bswap_32(hdr.ts_sec);
+            hdr.ts_usec  = bswap_32(hdr.ts_usec);
+            hdr.incl_len = bswap_32(hdr.incl_len);
+            hdr.orig_len = bswap_32(hdr.orig_len);
+        }
+        if (hdr.incl_len > self->snaplen) {
+            lwarning("invalid packet length, larger then snaplen");
+            err = -1;
+            break;
+        }
+        if (self->len - self->at - 16 < hdr.incl_len) {
+            lwarning("could not read all of packet, aborting");
+            err = -1;
+            break;
+        }
+        self->at += 16;
+
+        self->pkts++;
+
+        p         = &self->batch_pkts[n];
+        p->ts.sec = hdr.ts_sec;
+        if (self->is_nanosec) {
+            p->ts.nsec = hdr.ts_usec;
+        } else {
+            p->ts.nsec = hdr.ts_usec * 1000;
+        }
+        // packets point into the mapped file so nothing needs to be copied
+        p->bytes  = (unsigned char*)&self->buf[self->at];
+        p->caplen = hdr.incl_len;
+        p->len    = hdr.orig_len;
+
+        self->at += hdr.incl_len;
+
+        if (++n == self->batch_size) {
+            self->recv_batch(self->ctx, self->batch, n);
+            n = 0;
+        }
+    }
+    if (n) {
+        self->recv_batch(self->ctx, self->batch, n);
+    }
+    if (err) {
+        return err;
+    }
+    if (self->at < self->len) {
+        lwarning("could not read next PCAP header, aborting");
+        return -1;
+    }
+
+    return 0;
+}
+
 int input_mmpcap_run(input_mmpcap_t* self)
 {
     struct {
@@ -218,6 +306,9 @@ int input_mmpcap_run(input_mmpcap_t* self)
     if (!self->recv) {
         lfatal("no receiver set");
     }
+    if (self->recv_batch) {
+        return _run_batch(self);
+    }
 
     pkt.snaplen    = self->snaplen;
     pkt.linktype   = self->linktype;
@@ -48,6 +48,11 @@ typedef struct input_mmpcap {
     uint32_t network;
 
     uint32_t linktype;
+
+    core_receiver_batch_t recv_batch;
+    size_t                batch_size;
+    core_object_pcap_t*   batch_pkts;
+    const core_object_t** batch;
 } input_mmpcap_t;
 
 core_log_t* input_mmpcap_log();
@@ -101,7 +101,8 @@ static input_zpcap_t _defaults = {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0,
-    0
+    0,
+    0, 64, 0, 0, 0, 0
 };
 
 core_log_t* input_zpcap_log()
@@ -167,6 +168,9 @@ void input_zpcap_destroy(input_zpcap_t* self)
         fclose(self->file);
     }
     free(self->buf);
+    free(self->batch_pkts);
+    free(self->batch);
+    free(self->batch_buf);
 }
 
 static ssize_t _read(input_zpcap_t* self, void* dst, size_t len, void** dstp)
@@ -545,6 +549,106 @@ int input_zpcap_openfp(input_zpcap_t* self, void* fp)
     return _open(self);
 }
 
+static void _batch_init(input_zpcap_t* self)
+{
+    core_object_pcap_t pkt = CORE_OBJECT_PCAP_INIT(0);
+    size_t             n;
+
+    if (self->batch) {
+        return;
+    }
+    if (!self->batch_size) {
+        self->batch_size = 1;
+    }
+
+    pkt.snaplen    = self->snaplen;
+    pkt.linktype   = self->linktype;
+    pkt.is_swapped = self->is_swapped;
+
+    lfatal_oom(self->batch_pkts = malloc(sizeof(core_object_pcap_t) * self->batch_size));
+    lfatal_oom(self->batch = malloc(sizeof(core_object_t*) * self->batch_size));
+    for (n = 0; n < self->batch_size; n++) {
+        self->batch_pkts[n] = pkt;
+        self->batch[n]      = (core_object_t*)&self->batch_pkts[n];
+    }
+
+    // room for a batch of common sized packets but always for one full snaplen
+    self->batch_buf_size = self->batch_size * 2048;
+    if (self->batch_buf_size < self->snaplen) {
+        self->batch_buf_size = self->snaplen;
+    }
+    lfatal_oom(self->batch_buf = malloc(self->batch_buf_size));
+}
+
+static int _run_batch(input_zpcap_t* self)
+{
+    struct {
+        uint32_t ts_sec;
+        uint32_t ts_usec;
+        uint32_t incl_len;
+        uint32_t orig_len;
+    } hdr;
+    core_object_pcap_t* pkt;
+    size_t              n = 0, at = 0;
+    int                 ret, err = 0;
+
+    _batch_init(self);
+
+    while ((ret = _read(self, &hdr, 16, 0)) == 16) {
+        if (self->is_swapped) {
+            hdr.ts_sec   = bswap_32(hdr.ts_sec);
+            hdr.ts_usec  = bswap_32(hdr.ts_usec);
+            hdr.incl_len = bswap_32(hdr.incl_len);
+            hdr.orig_len = bswap_32(hdr.orig_len);
+        }
+        if (hdr.incl_len > self->snaplen) {
+            lwarning("invalid packet length, larger then snaplen");
+            err = -1;
+            break;
+        }
+        if (n == self->batch_size || self->batch_buf_size - at < hdr.incl_len) {
+            self->recv_batch(self->ctx, self->batch, n);
+            n  = 0;
+            at = 0;
+        }
+
+        pkt        = &self->batch_pkts[n];
+        pkt->bytes = self->batch_buf + at;
+        // decompressed data is reused so packets are copied out of it
+        if (_read(self, (void*)pkt->bytes, hdr.incl_len, 0) != hdr.incl_len) {
+            lwarning("could not read all of packet, aborting");
+            err = -1;
+            break;
+        }
+
+        self->pkts++;
+
+        pkt->ts.sec = hdr.ts_sec;
+        if (self->is_nanosec) {
+            pkt->ts.nsec = hdr.ts_usec;
+        } else {
+            pkt->ts.nsec = hdr.ts_usec * 1000;
+        }
+        pkt->caplen = hdr.incl_len;
+        pkt->len    = hdr.orig_len;
+
+        n++;
+        at += hdr.incl_len;
+    }
+    if (n) {
+        self->recv_batch(self->ctx, self->batch, n);
+    }
+    if (err) {
+        return err;
+    }
+    if (ret) {
+        lwarning("could not read next PCAP header, aborting");
+        return -1;
+    }
+
+    return 0;
+}
+
 int input_zpcap_run(input_zpcap_t* self)
 {
     struct {
@@ -563,6 +667,9 @@ int input_zpcap_run(input_zpcap_t* self)
     if (!self->recv) {
         lfatal("no receiver set");
     }
+    if (self->recv_batch) {
+        return _run_batch(self);
+    }
 
     pkt.snaplen    = self->snaplen;
     pkt.linktype   = self->linktype;
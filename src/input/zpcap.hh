@@ -65,6 +65,13 @@ typedef struct input_zpcap {
     uint32_t network;
 
     uint32_t linktype;
+
+    core_receiver_batch_t recv_batch;
+    size_t                batch_size;
+    core_object_pcap_t*   batch_pkts;
+    const core_object_t** batch;
+    uint8_t*              batch_buf;
+    size_t                batch_buf_size;
 } input_zpcap_t;
 
 core_log_t* input_zpcap_log();
@@ -24,6 +24,7 @@
 #include "core/assert.h"
 #include "core/object/dns.h"
 #include "core/object/payload.h"
+#include "core/object/packet.h"
 #include "core/object/udp.h"
 #include "core/object/tcp.h"
 
@@ -288,6 +289,10 @@ static void _receive_udp(output_dnscli_t* self, const core_object_t* obj)
     ssize_t        n;
     mlassert_self();
 
+    if (obj->obj_type == CORE_OBJECT_PACKET && !(obj = (const core_object_t*)((const core_object_packet_t*)obj)->payload)) {
+        return;
+    }
+
     switch (obj->obj_type) {
     case CORE_OBJECT_DNS:
         payload = ((core_object_dns_t*)obj)->payload;
@@ -371,6 +376,10 @@ static void _receive_tcp(output_dnscli_t* self, const core_object_t* obj)
     ssize_t        n;
     mlassert_self();
 
+    if (obj->obj_type == CORE_OBJECT_PACKET && !(obj = (const core_object_t*)((const core_object_packet_t*)obj)->payload)) {
+        return;
+    }
+
     switch (obj->obj_type) {
     case CORE_OBJECT_DNS:
         if (!((core_object_dns_t*)obj)->includes_dnslen) {
@@ -458,6 +467,10 @@ static void _receive_tls(output_dnscli_t* self, const core_object_t* obj)
     ssize_t        n;
     mlassert_self();
 
+    if (obj->obj_type == CORE_OBJECT_PACKET && !(obj = (const core_object_t*)((const core_object_packet_t*)obj)->payload)) {
+        return;
+    }
+
     switch (obj->obj_type) {
     case CORE_OBJECT_DNS:
         if (!((core_object_dns_t*)obj)->includes_dnslen) {
@@ -526,6 +539,10 @@ luajit_ssize_t output_dnscli_send(output_dnscli_t* self, const core_object_t* ob
     uint16_t       dnslen;
     mlassert_self();
 
+    if (obj->obj_type == CORE_OBJECT_PACKET && !(obj = (const core_object_t*)((const core_object_packet_t*)obj)->payload)) {
+        return -2;
+    }
+
     switch (self->mode & OUTPUT_DNSCLI_MODE_MODES) {
     case OUTPUT_DNSCLI_MODE_UDP:
         switch (obj->obj_type) {
@@ -24,6 +24,7 @@
 #include "core/assert.h"
 #include "core/object/dns.h"
 #include "core/object/payload.h"
+#include "core/object/packet.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -163,6 +164,9 @@ static void _receive(output_tlscli_t* self, const core_object_t* obj)
         case CORE_OBJECT_DNS:
             obj = obj->obj_prev;
             continue;
+        case CORE_OBJECT_PACKET:
+            obj = (const core_object_t*)((const core_object_packet_t*)obj)->payload;
+            continue;
         case CORE_OBJECT_PAYLOAD:
             payload = ((core_object_payload_t*)obj)->payload;
             len     = ((core_object_payload_t*)obj)->len;
@@ -18,18 +18,28 @@
  * along with dnsjit.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "config.h"
 
 #include "output/udpcli.h"
 #include "core/assert.h"
 #include "core/object/dns.h"
 #include "core/object/payload.h"
+#include "core/object/packet.h"
 
 #include <netdb.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
 #include <poll.h>
+#ifdef HAVE_SENDMMSG
+#include <sys/socket.h>
+
+#define MAX_BATCH 64
+#endif
 
 static core_log_t      _log      = LOG_T_INIT("output.udpcli");
 static output_udpcli_t _defaults = {
@@ -154,6 +164,9 @@ static void _receive(output_udpcli_t* self, const core_object_t* obj)
         case CORE_OBJECT_DNS:
             obj = obj->obj_prev;
             continue;
+        case CORE_OBJECT_PACKET:
+            obj = (const core_object_t*)((const core_object_packet_t*)obj)->payload;
+            continue;
         case CORE_OBJECT_PAYLOAD:
             payload = ((core_object_payload_t*)obj)->payload;
             len     = ((core_object_payload_t*)obj)->len;
@@ -188,6 +201,71 @@ static void _receive(output_udpcli_t* self, const core_object_t* obj)
     }
 }
 
+#ifdef HAVE_SENDMMSG
+static void _receive_batch(output_udpcli_t* self, const core_object_t** objs, size_t num)
+{
+    struct mmsghdr       msgs[MAX_BATCH];
+    struct iovec         iov[MAX_BATCH];
+    const core_object_t* obj;
+    size_t               n = 0, k, sent;
+    int                  ret;
+    mlassert_self();
+
+    while (n < num) {
+        for (k = 0; n < num && k < MAX_BATCH; n++) {
+            for (obj = objs[n]; obj && obj->obj_type == CORE_OBJECT_DNS;) {
+                obj = obj->obj_prev;
+            }
+            if (obj && obj->obj_type == CORE_OBJECT_PACKET) {
+                obj = (const core_object_t*)((const core_object_packet_t*)obj)->payload;
+            }
+            if (!obj || obj->obj_type != CORE_OBJECT_PAYLOAD) {
+                continue;
+            }
+
+            iov[k].iov_base = (void*)((core_object_payload_t*)obj)->payload;
+            iov[k].iov_len  = ((core_object_payload_t*)obj)->len;
+            memset(&msgs[k], 0, sizeof(msgs[k]));
+            msgs[k].msg_hdr.msg_name    = &self->addr;
+            msgs[k].msg_hdr.msg_namelen = self->addr_len;
+            msgs[k].msg_hdr.msg_iov     = &iov[k];
+            msgs[k].msg_hdr.msg_iovlen  = 1;
+            k++;
+        }
+
+        for (sent = 0; sent < k;) {
+            if ((ret = sendmmsg(self->fd, &msgs[sent], k - sent, 0)) > 0) {
+                sent += ret;
+                self->pkts += ret;
+                continue;
+            }
+            switch (errno) {
+            case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+            case EWOULDBLOCK:
+#endif
+                continue;
+            default:
+                break;
+            }
+            // skip the message that failed
+            self->errs++;
+            sent++;
+        }
+    }
+}
+#else
+static void _receive_batch(output_udpcli_t* self, const core_object_t** objs, size_t num)
+{
+    size_t n;
+    mlassert_self();
+
+    for (n = 0; n < num; n++) {
+        _receive(self, objs[n]);
+    }
+}
+#endif
+
 core_receiver_t output_udpcli_receiver(output_udpcli_t* self)
 {
     mlassert_self();
@@ -199,6 +277,17 @@ core_receiver_t output_udpcli_receiver(output_udpcli_t* self)
     return (core_receiver_t)_receive;
 }
 
+core_receiver_batch_t output_udpcli_receiver_batch(output_udpcli_t* self)
+{
+    mlassert_self();
+
+    if (self->fd < 0) {
+        lfatal("not connected");
+    }
+
+    return (core_receiver_batch_t)_receive_batch;
+}
+
 static const core_object_t* _produce(output_udpcli_t* self)
 {
     ssize_t n;
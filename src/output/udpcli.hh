@@ -49,5 +49,6 @@ int  output_udpcli_connect(output_udpcli_t* self, const char* host, const char*
 int  output_udpcli_nonblocking(output_udpcli_t* self);
 int  output_udpcli_set_nonblocking(output_udpcli_t* self, int nonblocking);
 
-core_receiver_t output_udpcli_receiver(output_udpcli_t* self);
+core_receiver_t       output_udpcli_receiver(output_udpcli_t* self);
+core_receiver_batch_t output_udpcli_receiver_batch(output_udpcli_t* self);
 core_producer_t output_udpcli_producer(output_udpcli_t* self);
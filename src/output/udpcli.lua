@@ -22,6 +22,9 @@
 --
 -- Simple and rather dumb DNS client that takes any payload you give it and
 -- sends the full payload over UDP.
+-- Batches of objects are sent with one
+-- .IR sendmmsg ()
+-- call where available.
 -- .SS Attributes
 -- .TP
 -- timeout
@@ -86,6 +89,11 @@ function Udpcli:receive()
     return C.output_udpcli_receiver(self.obj), self.obj
 end
 
+-- Return the C functions and context for receiving batches of objects.
+function Udpcli:receive_batch()
+    return C.output_udpcli_receiver_batch(self.obj), self.obj
+end
+
 -- Return the C functions and context for producing objects, these objects
 -- are received.
 -- If nonblocking mode is enabled the producer will return a payload object
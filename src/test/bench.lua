@@ -0,0 +1,379 @@
+-- Benchmark of DNS parsing and layer decoding
+--
+-- Runs the DNS parsers over the DNS payloads found in the given PCAPs and
+-- over a synthetic corpus, and the layer filter over the packets of the
+-- PCAPs loaded into memory.
+-- Results are printed and written as tab separated values to the output
+-- file so that runs can be compared between versions.
+local ffi = require("ffi")
+local C = ffi.C
+local clock = require("dnsjit.lib.clock")
+local object = require("dnsjit.core.objects")
+local dns = require("dnsjit.core.object.dns")
+local msg = require("dnsjit.core.object.dns.msg")
+local label = require("dnsjit.core.object.dns.label")
+local edns = require("dnsjit.core.object.dns.edns")
+local getopt = require("dnsjit.lib.getopt").new({
+    { "o", "output", "bench.out", "Write results to file", "?" },
+    { "n", "messages", 100000, "Number of messages in the synthetic corpus", "?" },
+    { "r", "rounds", 5, "Number of rounds over each corpus", "?" },
+    { "l", "label", "", "Label the results, for example with the version", "?" },
+})
+
+ffi.cdef[[
+struct bench_rusage {
+    struct { long sec, usec; } utime, stime;
+    long maxrss, ixrss, idrss, isrss, minflt, majflt, nswap, inblock, oublock, msgsnd, msgrcv, nsignals, nvcsw, nivcsw;
+};
+int getrusage(int who, struct bench_rusage* usage);
+]]
+
+local pcaps = getopt:parse()
+local rounds = getopt:val("r")
+
+local function now()
+    local sec, nsec = clock.monotonic()
+    return sec + nsec / 1000000000
+end
+
+local ru = ffi.new("struct bench_rusage")
+local function minflt()
+    C.getrusage(0, ru)
+    return tonumber(ru.minflt), tonumber(ru.maxrss)
+end
+
+-- A corpus is a single buffer of messages without DNS length
+local Corpus = {}
+
+function Corpus.new(name)
+    return setmetatable({ name = name, msgs = {}, size = 0 }, { __index = Corpus })
+end
+
+function Corpus:add(ptr, len)
+    table.insert(self.msgs, ffi.string(ptr, len))
+    self.size = self.size + len
+end
+
+function Corpus:finalize()
+    local n = #self.msgs
+    self.n = n
+    self.buf = ffi.new("uint8_t[?]", self.size)
+    self.off = ffi.new("size_t[?]", n)
+    self.len = ffi.new("size_t[?]", n)
+    local at = 0
+    for i, m in ipairs(self.msgs) do
+        ffi.copy(self.buf + at, m, #m)
+        self.off[i - 1] = at
+        self.len[i - 1] = #m
+        at = at + #m
+    end
+    self.msgs = nil
+end
+
+local function pcap_corpus(file)
+    local corpus = Corpus.new(file)
+    local input = require("dnsjit.input.fpcap").new()
+    local layer = require("dnsjit.filter.layer").new()
+    input:open(file)
+    layer:producer(input)
+    local prod, pctx = layer:produce()
+    while true do
+        local obj = prod(pctx)
+        if obj == nil then break end
+        if obj:type() == "payload" then
+            local pl = obj:cast()
+            if obj.obj_prev:type() == "tcp" then
+                if pl.len > 2 then
+                    corpus:add(pl.payload + 2, pl.len - 2)
+                end
+            elseif pl.len > 0 then
+                corpus:add(pl.payload, pl.len)
+            end
+        end
+    end
+    return corpus
+end
+
+-- Synthetic messages, a mix of queries and responses with compressed
+-- names, various record types and EDNS0 options
+local function u16(n)
+    return string.char(bit.band(bit.rshift(n, 8), 0xff), bit.band(n, 0xff))
+end
+
+local function u32(n)
+    return u16(bit.band(bit.rshift(n, 16), 0xffff)) .. u16(bit.band(n, 0xffff))
+end
+
+local tlds = { "com", "net", "org", "se", "nl", "de", "arpa" }
+local types = { 1, 28, 15, 2, 16, 6, 12, 33 }
+
+local function rlabel()
+    local t = {}
+    for i = 1, math.random(1, 20) do
+        t[i] = string.char(math.random(97, 122))
+    end
+    return string.char(#t) .. table.concat(t)
+end
+
+local function rname()
+    local t = {}
+    for i = 1, math.random(1, 4) do
+        t[i] = rlabel()
+    end
+    local tld = tlds[math.random(#tlds)]
+    return table.concat(t) .. string.char(#tld) .. tld .. "\0"
+end
+
+local function rrdata(type)
+    if type == 1 then
+        return u32(math.random(0, 0x7fffffff))
+    elseif type == 28 then
+        return u32(0x20010db8) .. u32(0) .. u32(0) .. u32(math.random(0, 0xffff))
+    elseif type == 15 then
+        return u16(10) .. rlabel() .. "\192\12"
+    elseif type == 2 or type == 12 then
+        return rlabel() .. "\192\12"
+    elseif type == 16 then
+        local l = rlabel()
+        return l .. l
+    elseif type == 6 then
+        return rlabel() .. "\192\12" .. rlabel() .. "\192\12" .. u32(1) .. u32(7200) .. u32(3600) .. u32(1209600) .. u32(300)
+    elseif type == 33 then
+        return u16(0) .. u16(5) .. u16(5060) .. rlabel() .. "\192\12"
+    end
+end
+
+local function synthetic(n)
+    local corpus = Corpus.new("synthetic")
+    math.randomseed(4711)
+    for i = 1, n do
+        local type = types[math.random(#types)]
+        local response = math.random() < 0.5
+        local answers = response and math.random(1, 5) or 0
+        local opt = ""
+        if math.random() < 0.7 then
+            local options = ""
+            if math.random() < 0.3 then
+                options = u16(8) .. u16(7) .. u16(1) .. "\24\0\192\0\2"
+            end
+            if math.random() < 0.3 then
+                options = options .. u16(10) .. u16(8) .. u32(i) .. u32(n)
+            end
+            opt = "\0" .. u16(41) .. u16(1232) .. u32(0x8000) .. u16(#options) .. options
+        end
+        local m = {
+            u16(i % 65536), response and "\129\128" or "\1\0",
+            u16(1), u16(answers), u16(0), u16(opt ~= "" and 1 or 0),
+            rname(), u16(type), u16(1),
+        }
+        for a = 1, answers do
+            local rdata = rrdata(type)
+            table.insert(m, "\192\12" .. u16(type) .. u16(1) .. u32(300) .. u16(#rdata) .. rdata)
+        end
+        table.insert(m, opt)
+        local s = table.concat(m)
+        corpus:add(s, #s)
+    end
+    return corpus
+end
+
+-- Benchmarks, each is run over all messages of the corpus for a number of
+-- rounds and returns the number of messages successfully handled
+local pl = ffi.new("core_object_payload_t")
+pl.obj_type = object.PAYLOAD
+local d = dns.new(ffi.cast("core_object_t*", pl))
+local m = msg.new()
+local e = edns.new()
+local q = ffi.new("core_object_dns_q_t")
+local rr = ffi.new("core_object_dns_rr_t")
+local labels = label.new(16)
+local name = ffi.new("uint8_t[1024]")
+
+local benchmarks = {
+    { "parse_header", function(corpus)
+        local ok = 0
+        for i = 0, corpus.n - 1 do
+            pl.payload = corpus.buf + corpus.off[i]
+            pl.len = corpus.len[i]
+            if C.core_object_dns_parse_header(d) == 0 then
+                ok = ok + 1
+            end
+        end
+        return ok
+    end },
+    { "parse_q_rr", function(corpus)
+        local ok = 0
+        for i = 0, corpus.n - 1 do
+            pl.payload = corpus.buf + corpus.off[i]
+            pl.len = corpus.len[i]
+            local ret = C.core_object_dns_parse_header(d)
+            if ret == 0 then
+                for n = 1, d.qdcount do
+                    ret = C.core_object_dns_parse_q(d, q, labels, 16)
+                    if ret ~= 0 then break end
+                end
+            end
+            if ret == 0 then
+                for n = 1, d.ancount + d.nscount + d.arcount do
+                    ret = C.core_object_dns_parse_rr(d, rr, labels, 16)
+                    if ret ~= 0 then break end
+                end
+            end
+            if ret == 0 then
+                ok = ok + 1
+            end
+        end
+        return ok
+    end },
+    { "parse_msg", function(corpus)
+        local ok = 0
+        for i = 0, corpus.n - 1 do
+            pl.payload = corpus.buf + corpus.off[i]
+            pl.len = corpus.len[i]
+            if C.core_object_dns_parse_msg(d, m) == 0 then
+                ok = ok + 1
+            end
+        end
+        return ok
+    end },
+    { "parse_edns", function(corpus)
+        local ok = 0
+        for i = 0, corpus.n - 1 do
+            pl.payload = corpus.buf + corpus.off[i]
+            pl.len = corpus.len[i]
+            if C.core_object_dns_parse_edns(d, e) == 0 then
+                ok = ok + 1
+            end
+        end
+        return ok
+    end },
+    { "qname", function(corpus)
+        local ok = 0
+        for i = 0, corpus.n - 1 do
+            pl.payload = corpus.buf + corpus.off[i]
+            pl.len = corpus.len[i]
+            if C.core_object_dns_parse_header(d) == 0 and C.core_object_dns_qname(d, 1, name, 1024) > 0 then
+                ok = ok + 1
+            end
+        end
+        return ok
+    end },
+}
+
+local results = {}
+
+local function run(bench, corpus, func)
+    func(corpus)
+    collectgarbage("collect")
+    collectgarbage("stop")
+    local kb, flt = collectgarbage("count"), minflt()
+    local ok = 0
+    local start = now()
+    for r = 1, rounds do
+        ok = ok + func(corpus)
+    end
+    local secs = now() - start
+    local flt2, rss = minflt()
+    local alloc = math.floor((collectgarbage("count") - kb) * 1024)
+    collectgarbage("restart")
+
+    local msgs = corpus.n * rounds
+    local res = {
+        bench = bench,
+        corpus = corpus.name,
+        messages = msgs,
+        ok = ok,
+        seconds = secs,
+        rate = secs > 0 and msgs / secs or 0,
+        ns = msgs > 0 and secs * 1000000000 / msgs or 0,
+        alloc = alloc,
+        minflt = flt2 - flt,
+        maxrss = rss,
+    }
+    table.insert(results, res)
+    print(string.format("%-14s %-24s %10d msgs %12.0f msgs/s %9.1f ns/msg %8d bytes allocated %6d page faults",
+        bench, corpus.name, msgs, res.rate, res.ns, alloc, res.minflt))
+end
+
+-- Layer decoding runs over the packets of a PCAP loaded into memory once,
+-- only the layer filter and the channel collecting its output are timed
+local function layer_corpus(file)
+    local input = require("dnsjit.input.fpcap").new()
+    input:open(file)
+    local prod, pctx = input:produce()
+    local pkts, size = {}, 0
+    while true do
+        local obj = prod(pctx)
+        if obj == nil then break end
+        local pkt = obj:cast()
+        table.insert(pkts, { snaplen = pkt.snaplen, linktype = pkt.linktype, sec = pkt.ts.sec, nsec = pkt.ts.nsec,
+            len = pkt.len, is_swapped = pkt.is_swapped, bytes = ffi.string(pkt.bytes, pkt.caplen) })
+        size = size + pkt.caplen
+    end
+
+    local corpus = { name = file, n = #pkts }
+    corpus.buf = ffi.new("uint8_t[?]", size)
+    corpus.pkts = ffi.new("core_object_pcap_t[?]", corpus.n)
+    local at = 0
+    for i, p in ipairs(pkts) do
+        local pkt = corpus.pkts[i - 1]
+        pkt.obj_type = object.PCAP
+        pkt.snaplen = p.snaplen
+        pkt.linktype = p.linktype
+        pkt.ts.sec = p.sec
+        pkt.ts.nsec = p.nsec
+        pkt.len = p.len
+        pkt.is_swapped = p.is_swapped
+        pkt.caplen = #p.bytes
+        pkt.bytes = corpus.buf + at
+        ffi.copy(corpus.buf + at, p.bytes, #p.bytes)
+        at = at + #p.bytes
+    end
+
+    local capacity = 4
+    while capacity <= corpus.n do
+        capacity = capacity * 2
+    end
+    corpus.chan = require("dnsjit.core.channel").new(capacity)
+    corpus.objs = ffi.new("void*[?]", capacity)
+    corpus.layer = require("dnsjit.filter.layer").new()
+    corpus.layer:receiver(corpus.chan)
+    corpus.recv, corpus.rctx = corpus.layer:receive()
+    return corpus
+end
+
+local function layer_decode(corpus)
+    local recv, rctx, pkts = corpus.recv, corpus.rctx, corpus.pkts
+    for i = 0, corpus.n - 1 do
+        recv(rctx, ffi.cast("core_object_t*", pkts + i))
+    end
+    return corpus.chan:try_get_many(corpus.objs, corpus.n)
+end
+
+local corpora = {}
+for _, file in pairs(pcaps) do
+    local corpus = pcap_corpus(file)
+    corpus:finalize()
+    table.insert(corpora, corpus)
+end
+local corpus = synthetic(getopt:val("n"))
+corpus:finalize()
+table.insert(corpora, corpus)
+
+for _, corpus in pairs(corpora) do
+    for _, bench in pairs(benchmarks) do
+        run(bench[1], corpus, bench[2])
+    end
+end
+for _, file in pairs(pcaps) do
+    run("layer", layer_corpus(file), layer_decode)
+end
+
+local out = assert(io.open(getopt:val("o"), "w"))
+out:write("# dnsjit bench " .. getopt:val("l") .. " rounds " .. rounds .. "\n")
+out:write("benchmark\tcorpus\tmessages\tok\tseconds\tmsgs_per_sec\tns_per_msg\tlua_alloc_bytes\tminflt\tmaxrss_kb\n")
+for _, r in pairs(results) do
+    out:write(string.format("%s\t%s\t%d\t%d\t%.6f\t%.0f\t%.1f\t%d\t%d\t%d\n",
+        r.bench, r.corpus, r.messages, r.ok, r.seconds, r.rate, r.ns, r.alloc, r.minflt, r.maxrss))
+end
+out:close()
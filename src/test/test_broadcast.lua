@@ -0,0 +1,124 @@
+-- Test cases for dnsjit.core.broadcast
+local ffi = require("ffi")
+local broadcast = require("dnsjit.core.broadcast")
+local channel = require("dnsjit.core.channel")
+local thread = require("dnsjit.core.thread")
+local clock = require("dnsjit.lib.clock")
+
+local function ptr(n)
+    return ffi.cast("void*", n)
+end
+
+local function num(p)
+    return tonumber(ffi.cast("intptr_t", p))
+end
+
+local function pause(ms)
+    local sec, nsec = clock.monotonic()
+    local until_ns = sec * 1000000000 + nsec + ms * 1000000
+    repeat
+        sec, nsec = clock.monotonic()
+    until sec * 1000000000 + nsec >= until_ns
+end
+
+-----------------------------------------------------
+--   All consumers get all objects
+-----------------------------------------------------
+local bc = broadcast.new(4, 2)
+for n = 1, 4 do
+    assert(bc:try_put(ptr(n)) == 0, "broadcast: try_put failed")
+end
+assert(bc:try_put(ptr(5)) ~= 0, "broadcast: try_put on full ring")
+for n = 1, 4 do
+    assert(num(bc:get(0)) == n, "broadcast: consumer 0 wrong object")
+end
+bc:release(0)
+assert(bc:try_put(ptr(5)) ~= 0, "broadcast: slot reused before all consumers passed")
+assert(num(bc:get(1)) == 1, "broadcast: consumer 1 wrong object")
+assert(bc:try_put(ptr(5)) ~= 0, "broadcast: slot reused before consumer released it")
+assert(num(bc:get(1)) == 2, "broadcast: consumer 1 wrong object")
+assert(bc:try_put(ptr(5)) == 0, "broadcast: slot not reclaimed")
+assert(bc:try_get(0) ~= nil, "broadcast: consumer 0 missing object")
+assert(bc:try_get(0) == nil, "broadcast: consumer 0 extra object")
+
+-----------------------------------------------------
+--   Consumer threads get all objects
+-----------------------------------------------------
+bc = broadcast.new(64, 2)
+local out = channel.new(4096, channel.MPSC)
+local threads = {}
+for t = 0, 1 do
+    local thr = thread.new()
+    thr:start(function(thr)
+        local ffi = require("ffi")
+        local bc, consumer, out = thr:pop(3)
+        while true do
+            local obj = bc:get(consumer)
+            if obj == nil then
+                break
+            end
+            out:put(ffi.cast("void*", tonumber(ffi.cast("intptr_t", obj)) + consumer * 10000))
+        end
+    end)
+    thr:push(bc, t, out)
+    table.insert(threads, thr)
+end
+for n = 1, 1000 do
+    bc:put(ptr(n))
+end
+local seen = {}
+for n = 1, 2000 do
+    local v = num(out:get())
+    assert(seen[v] == nil, "broadcast: duplicate object")
+    seen[v] = true
+end
+bc:close()
+for _, thr in pairs(threads) do
+    thr:stop()
+end
+
+-----------------------------------------------------
+--   Adaptive wait: consumer sleeps until woken
+-----------------------------------------------------
+bc = broadcast.new(16, 1)
+bc.spin = 10
+out = channel.new(16)
+local thr = thread.new()
+thr:start(function(thr)
+    local bc, out = thr:pop(2)
+    while true do
+        local obj = bc:get(0)
+        if obj == nil then
+            break
+        end
+        out:put(obj)
+    end
+end)
+thr:push(bc, out)
+for n = 1, 3 do
+    pause(20)
+    bc:put(ptr(n))
+    assert(num(out:get()) == n, "broadcast: wrong object after pause")
+end
+bc:close()
+thr:stop()
+assert(bc.get_sleeps > 0, "broadcast: consumer never slept")
+
+-- Closing a full broadcast wakes a producer sleeping in put()
+bc = broadcast.new(4, 1)
+bc.spin = 10
+for n = 1, 4 do
+    bc:put(ptr(n))
+end
+thr = thread.new()
+thr:start(function(thr)
+    local ffi = require("ffi")
+    local bc = thr:pop()
+    bc:put(ffi.cast("void*", 5))
+end)
+thr:push(bc)
+pause(50)
+bc:close()
+thr:stop()
+assert(bc.put_sleeps > 0, "close: producer never slept")
+assert(bc:size() == 4, "close: object put after close")
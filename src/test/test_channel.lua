@@ -0,0 +1,336 @@
+-- Test cases for dnsjit.core.channel
+local ffi = require("ffi")
+local channel = require("dnsjit.core.channel")
+local thread = require("dnsjit.core.thread")
+
+local function ptr(n)
+    return ffi.cast("void*", n)
+end
+
+local function num(p)
+    return tonumber(ffi.cast("intptr_t", p))
+end
+
+-----------------------------------------------------
+--   All modes: fill, check full, drain in order
+-----------------------------------------------------
+for _, mode in pairs({ channel.SPSC, channel.MPSC, channel.SPMC, channel.MPMC }) do
+    local chan = channel.new(16, mode)
+    for n = 1, 15 do
+        assert(chan:try_put(ptr(n)) == 0, mode .. ": try_put failed")
+    end
+    assert(chan:full(), mode .. ": not full")
+    assert(chan:try_put(ptr(16)) ~= 0, mode .. ": try_put on full channel")
+    assert(chan:size() == 15, mode .. ": wrong size")
+    for n = 1, 15 do
+        assert(num(chan:get()) == n, mode .. ": wrong object order")
+    end
+    assert(chan:try_get() == nil, mode .. ": channel not empty")
+    chan:close()
+    assert(chan:get() == nil, mode .. ": get on closed channel")
+end
+
+-----------------------------------------------------
+--   All modes: batched put/get with wrap around
+-----------------------------------------------------
+for _, mode in pairs({ channel.SPSC, channel.MPSC, channel.SPMC, channel.MPMC }) do
+    local chan = channel.new(16, mode)
+    local objs = ffi.new("void*[?]", 32)
+    local put, expect = 1, 1
+    for round = 1, 4 do
+        for i = 0, 9 do
+            objs[i] = ptr(put + i)
+        end
+        assert(chan:try_put_many(objs, 10) == 10, mode .. ": try_put_many failed")
+        put = put + 10
+        local n = chan:get_many(objs, 32)
+        assert(n == 10, mode .. ": get_many wrong count")
+        for i = 0, n - 1 do
+            assert(num(objs[i]) == expect, mode .. ": wrong object order")
+            expect = expect + 1
+        end
+    end
+    for i = 0, 19 do
+        objs[i] = ptr(i + 1)
+    end
+    assert(chan:try_put_many(objs, 20) == 15, mode .. ": try_put_many overfilled")
+    assert(chan:full(), mode .. ": not full")
+    assert(chan:try_get_many(objs, 4) == 4, mode .. ": try_get_many wrong count")
+    assert(num(objs[0]) == 1 and num(objs[3]) == 4, mode .. ": wrong objects")
+    assert(chan:try_get_many(objs, 32) == 11, mode .. ": try_get_many wrong count")
+    assert(chan:try_get_many(objs, 32) == 0, mode .. ": channel not empty")
+    chan:close()
+    assert(chan:get_many(objs, 32) == 0, mode .. ": get_many on closed channel")
+end
+
+-----------------------------------------------------
+--   MPSC: fan-in from multiple threads
+-----------------------------------------------------
+local chan = channel.new(64, channel.MPSC)
+local threads = {}
+for t = 1, 2 do
+    local thr = thread.new()
+    thr:start(function(thr)
+        local ffi = require("ffi")
+        local chan, base = thr:pop(2)
+        for n = 1, 1000 do
+            chan:put(ffi.cast("void*", base + n))
+        end
+    end)
+    thr:push(chan, t * 10000)
+    table.insert(threads, thr)
+end
+
+local seen = {}
+for n = 1, 2000 do
+    local v = num(chan:get())
+    assert(seen[v] == nil, "MPSC: duplicate object")
+    seen[v] = true
+end
+for _, thr in pairs(threads) do
+    thr:stop()
+end
+assert(chan:try_get() == nil, "MPSC: channel not empty")
+
+-----------------------------------------------------
+--   MPMC: batched fan-in and fan-out
+-----------------------------------------------------
+chan = channel.new(64, channel.MPMC)
+local out = channel.new(4096, channel.MPSC)
+threads = {}
+for t = 1, 2 do
+    local thr = thread.new()
+    thr:start(function(thr)
+        local ffi = require("ffi")
+        local chan, base = thr:pop(2)
+        local objs = ffi.new("void*[?]", 16)
+        for n = 0, 999, 10 do
+            for i = 0, 9 do
+                objs[i] = ffi.cast("void*", base + n + i + 1)
+            end
+            chan:put_many(objs, 10)
+        end
+    end)
+    thr:push(chan, t * 10000)
+    table.insert(threads, thr)
+end
+for t = 1, 2 do
+    local thr = thread.new()
+    thr:start(function(thr)
+        local ffi = require("ffi")
+        local chan, out = thr:pop(2)
+        local objs = ffi.new("void*[?]", 16)
+        while true do
+            local n = chan:get_many(objs, 16)
+            if n == 0 then
+                break
+            end
+            out:put_many(objs, n)
+        end
+    end)
+    thr:push(chan, out)
+    table.insert(threads, thr)
+end
+
+seen = {}
+for n = 1, 2000 do
+    local v = num(out:get())
+    assert(seen[v] == nil, "MPMC: duplicate object")
+    seen[v] = true
+end
+threads[1]:stop()
+threads[2]:stop()
+chan:close()
+threads[3]:stop()
+threads[4]:stop()
+assert(out:try_get() == nil, "MPMC: channel not empty")
+
+-----------------------------------------------------
+--   Wait strategies: consumer sleeps until woken
+-----------------------------------------------------
+for _, wait in pairs({ channel.ADAPTIVE, channel.YIELD, channel.SPIN }) do
+    local chan = channel.new(16)
+    local back = channel.new(16)
+    chan.wait = wait
+    chan.spin = 10
+    local thr = thread.new()
+    thr:start(function(thr)
+        local chan, back = thr:pop(2)
+        while true do
+            local obj = chan:get()
+            if obj == nil then
+                break
+            end
+            back:put(obj)
+        end
+    end)
+    thr:push(chan, back)
+    for n = 1, 100 do
+        chan:put(ptr(n))
+        assert(num(back:get()) == n, wait .. ": wrong object")
+    end
+    chan:close()
+    thr:stop()
+    if wait == channel.ADAPTIVE then
+        assert(chan.get_spins > 0, wait .. ": consumer never spun")
+    else
+        assert(chan.get_sleeps == 0, wait .. ": consumer slept")
+    end
+end
+
+-- The producer pauses longer than the spin budget so the consumer has to
+-- sleep and be woken for each object
+do
+    local clock = require("dnsjit.lib.clock")
+    local function pause(ms)
+        local sec, nsec = clock.monotonic()
+        local until_ns = sec * 1000000000 + nsec + ms * 1000000
+        repeat
+            sec, nsec = clock.monotonic()
+        until sec * 1000000000 + nsec >= until_ns
+    end
+
+    local chan = channel.new(16)
+    local back = channel.new(16)
+    chan.wait = channel.ADAPTIVE
+    chan.spin = 10
+    local thr = thread.new()
+    thr:start(function(thr)
+        local chan, back = thr:pop(2)
+        while true do
+            local obj = chan:get()
+            if obj == nil then
+                break
+            end
+            back:put(obj)
+        end
+    end)
+    thr:push(chan, back)
+    for n = 1, 5 do
+        pause(20)
+        chan:put(ptr(n))
+        assert(num(back:get()) == n, "adaptive: wrong object after pause")
+    end
+    chan:close()
+    thr:stop()
+    assert(chan.get_sleeps > 0, "adaptive: consumer never slept")
+end
+
+-- Closing a full channel wakes a producer sleeping in put()
+do
+    local clock = require("dnsjit.lib.clock")
+    local function pause(ms)
+        local sec, nsec = clock.monotonic()
+        local until_ns = sec * 1000000000 + nsec + ms * 1000000
+        repeat
+            sec, nsec = clock.monotonic()
+        until sec * 1000000000 + nsec >= until_ns
+    end
+
+    local chan = channel.new(16)
+    chan.wait = channel.ADAPTIVE
+    chan.spin = 10
+    for n = 1, 15 do
+        chan:put(ptr(n))
+    end
+    local thr = thread.new()
+    thr:start(function(thr)
+        local ffi = require("ffi")
+        local chan = thr:pop()
+        chan:put(ffi.cast("void*", 16))
+    end)
+    thr:push(chan)
+    pause(50)
+    chan:close()
+    thr:stop()
+    assert(chan.put_sleeps > 0, "close: producer never slept")
+    assert(chan.dropped == 1, "close: object not dropped")
+end
+
+-----------------------------------------------------
+--   Poller: wait on multiple channels
+-----------------------------------------------------
+local poller = require("dnsjit.core.poller").new()
+local chan1 = channel.new(16)
+local chan2 = channel.new(16)
+assert(poller:add(chan1), "poller: add failed")
+assert(poller:add(chan2), "poller: add failed")
+assert(poller:add(-1) == nil, "poller: added invalid fd")
+assert(poller:add({}) == nil, "poller: added object without fd")
+assert(#poller:wait(10) == 0, "poller: ready without objects")
+
+chan1:put(ptr(1))
+local ready = poller:wait(10)
+assert(#ready == 1 and ready[1] == chan1, "poller: chan1 not ready")
+assert(num(chan1:get()) == 1, "poller: wrong object")
+
+local thr = thread.new()
+thr:start(function(thr)
+    local ffi = require("ffi")
+    local chan = thr:pop()
+    chan:put(ffi.cast("void*", 2))
+end)
+thr:push(chan2)
+ready = poller:wait(-1)
+assert(#ready == 1 and ready[1] == chan2, "poller: chan2 not ready")
+assert(num(chan2:get()) == 2, "poller: wrong object")
+thr:stop()
+
+chan1:close()
+ready = poller:wait(10)
+assert(#ready == 1 and ready[1] == chan1, "poller: closed chan1 not ready")
+
+-----------------------------------------------------
+--   Overload policies
+-----------------------------------------------------
+for _, mode in pairs({ channel.SPSC, channel.MPMC }) do
+    chan = channel.new(4, mode)
+    chan.overload = channel.DROP_NEWEST
+    for n = 1, 5 do
+        chan:put(ptr(n))
+    end
+    assert(chan.dropped == 2, mode .. ": DROP_NEWEST wrong dropped count")
+    for n = 1, 3 do
+        assert(num(chan:try_get()) == n, mode .. ": DROP_NEWEST wrong object")
+    end
+
+    chan = channel.new(4, mode)
+    chan.overload = channel.DROP_OLDEST
+    for n = 1, 5 do
+        chan:put(ptr(n))
+    end
+    local objs = ffi.new("void*[?]", 4)
+    for i = 0, 3 do
+        objs[i] = ptr(i + 6)
+    end
+    chan:put_many(objs, 4)
+    assert(chan.dropped == 6, mode .. ": DROP_OLDEST wrong dropped count")
+    for n = 7, 9 do
+        assert(num(chan:try_get()) == n, mode .. ": DROP_OLDEST wrong object")
+    end
+end
+
+-----------------------------------------------------
+--   Statistics
+-----------------------------------------------------
+chan = channel.new(16)
+chan.track_occupancy = 1
+for n = 1, 12 do
+    chan:put(ptr(n))
+end
+for n = 1, 12 do
+    chan:get()
+end
+local stats = chan:stats()
+assert(stats.capacity == 16 and stats.size == 0, "stats: wrong capacity or size")
+assert(stats.high_water == 12, "stats: wrong high-water mark")
+local puts = 0
+for _, count in pairs(stats.occupancy) do
+    puts = puts + count
+end
+assert(puts == 12, "stats: wrong occupancy sample count")
+assert(stats.occupancy[1] == 1 and stats.occupancy[6] == 2 and stats.occupancy[7] == 1, "stats: wrong occupancy histogram")
+chan:close()
+chan:get()
+stats = chan:stats()
+assert(stats.get_idles == 1 and stats.put_stalls == 0, "stats: wrong stall/idle count")
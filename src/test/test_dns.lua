@@ -0,0 +1,262 @@
+-- Test cases for dnsjit.core.object.dns
+local ffi = require("ffi")
+local object = require("dnsjit.core.objects")
+local dns = require("dnsjit.core.object.dns")
+local msg = require("dnsjit.core.object.dns.msg")
+local label = require("dnsjit.core.object.dns.label")
+local edns = require("dnsjit.core.object.dns.edns")
+local edit = require("dnsjit.core.object.dns.edit")
+
+local function payloads(file, func)
+    local input = require("dnsjit.input.fpcap").new()
+    local layer = require("dnsjit.filter.layer").new()
+    input:open(file)
+    layer:producer(input)
+    local prod, pctx = layer:produce()
+    while true do
+        local obj = prod(pctx)
+        if obj == nil then break end
+        if obj:type() == "payload" and obj:cast().len > 0 then
+            func(obj, obj.obj_prev:type() == "tcp")
+        end
+    end
+end
+
+local function craft(bytes)
+    local buf = ffi.new("uint8_t[?]", #bytes)
+    ffi.copy(buf, bytes, #bytes)
+    local pl = ffi.new("core_object_payload_t")
+    pl.obj_type = object.PAYLOAD
+    pl.payload = buf
+    pl.len = #bytes
+    local d = dns.new(ffi.cast("core_object_t*", pl))
+    assert(d:parse_header() == 0, "crafted header")
+    return { d = d, pl = pl, buf = buf }
+end
+
+local header = "\0\1\1\0\0\1\0\1\0\0\0\0"
+
+-----------------------------------------------------
+--   parse_msg: same result as parse()
+-----------------------------------------------------
+local m = msg.new()
+local q = dns.new()
+local d = dns.new()
+local msgs = 0
+payloads("dns.pcap-dist", function(obj, tcp)
+    q:reset()
+    d:reset()
+    q.obj_prev = obj
+    d.obj_prev = obj
+    if tcp then
+        q.includes_dnslen = 1
+        d.includes_dnslen = 1
+    end
+
+    local ret, qs, qls, rrs, rrls = q:parse()
+    assert(d:parse_msg(m) == ret, "result differs from parse()")
+    assert(m.error == ret, "error not set")
+    if ret ~= 0 then
+        return
+    end
+    msgs = msgs + 1
+
+    assert(m.qdcount == d.qdcount and m.ancount == d.ancount and m.nscount == d.nscount and m.arcount == d.arcount, "section counts")
+    assert(m.rrs == #qs + #rrs, "number of records")
+    for n, rec in ipairs(qs) do
+        local i = n - 1
+        assert(m.section[i] == msg.QUESTION, "question section")
+        assert(m.type[i] == rec.type and m.class[i] == rec.class, "question type/class")
+        assert(m:name(d, i) == label.tostring(q, qls[n], rec.labels), "question name")
+    end
+    for n, rec in ipairs(rrs) do
+        local i = #qs + n - 1
+        assert(m.section[i] ~= msg.QUESTION, "record section")
+        assert(m.type[i] == rec.type and m.class[i] == rec.class and m.ttl[i] == rec.ttl, "record type/class/ttl")
+        assert(m.rdlength[i] == rec.rdlength and m.rdata_offset[i] == rec.rdata_offset, "record rdata")
+        assert(m.label_count[i] == rec.labels and m.rdata_label_count[i] == rec.rdata_labels, "record labels")
+        assert(m:name(d, i) == label.tostring(q, rrls[n], rec.labels), "record name")
+    end
+end)
+assert(msgs > 0, "no messages parsed")
+
+-----------------------------------------------------
+--   parse_msg: out of space for records
+-----------------------------------------------------
+local small = msg.new(1, 512)
+local full = false
+payloads("dns.pcap-dist", function(obj, tcp)
+    d:reset()
+    d.obj_prev = obj
+    if tcp then
+        d.includes_dnslen = 1
+    end
+    if d:parse_header() == 0 and d.qdcount + d.ancount + d.nscount + d.arcount > 1 then
+        assert(d:parse_msg(small) == -4, "expected need more records")
+        assert(small.rrs == 1 and small.error_rr == 1 and small.error_offset > 12, "error position")
+        full = true
+    end
+end)
+assert(full, "no message with more than one record")
+
+-----------------------------------------------------
+--   name/qname: decompress and lowercase
+-----------------------------------------------------
+local c = craft(header .. "\3WwW\7ExAmPlE\3CoM\0\0\1\0\1" .. "\192\12\0\1\0\1\0\0\0\1\0\4\1\2\3\4")
+assert(c.d:qname() == "www.example.com.", "qname presentation")
+assert(c.d:qname(true) == "\3www\7example\3com\0", "qname wire")
+assert(c.d:name(33) == "www.example.com.", "name through pointer")
+assert(c.d:name(33, true) == "\3www\7example\3com\0", "name wire through pointer")
+
+c = craft(header .. "\0\0\1\0\1")
+assert(c.d:qname() == ".", "root presentation")
+assert(c.d:qname(true) == "\0", "root wire")
+
+c = craft(header .. "\3a.B\1\255\0\0\1\0\1")
+assert(c.d:qname() == "a\\.b.\\255.", "escaped presentation")
+
+c = craft(header .. "\192\12\0\1\0\1")
+assert(c.d:qname() == nil, "pointer loop")
+c = craft(header .. "\1a\192\12\0\1\0\1")
+assert(c.d:qname() == nil, "pointer loop after label")
+c = craft(header .. "\192\16\0\1\1a\0")
+assert(c.d:qname() == nil, "forward pointer")
+c = craft(header .. "\3www")
+assert(c.d:qname() == nil, "truncated")
+c = craft("\0\1\1\0\0\0\0\1\0\0\0\0" .. "\3www\0\0\1\0\1")
+assert(c.d:qname() == nil, "no question")
+
+-----------------------------------------------------
+--   qname: matches the parsed question labels
+-----------------------------------------------------
+local names = 0
+payloads("dns.pcap-dist", function(obj, tcp)
+    d:reset()
+    d.obj_prev = obj
+    if tcp then
+        d.includes_dnslen = 1
+    end
+    if d:parse_msg(m) == 0 and m.qdcount > 0 and m:name(d, 0) then
+        assert(d:qname() == string.lower(m:name(d, 0)), "qname differs from labels")
+        names = names + 1
+    end
+end)
+assert(names > 0, "no names compared")
+
+-----------------------------------------------------
+--   parse_edns: OPT record and options
+-----------------------------------------------------
+local opts = "\0\8\0\7\0\1\24\0\192\0\2"
+    .. "\0\10\0\8\1\2\3\4\5\6\7\8"
+    .. "\0\15\0\6\0\18abcd"
+    .. "\0\12\0\2\0\0"
+local e = edns.new()
+c = craft("\0\1\1\0\0\1\0\0\0\0\0\1" .. "\3www\7example\3com\0\0\1\0\1"
+    .. "\0\0\41\4\208\0\0\128\0\0" .. string.char(#opts) .. opts)
+assert(c.d:parse_edns(e) == 0, "parse_edns failed")
+assert(e.have_opt == 1 and e.udp_size == 1232 and e.version == 0 and e.dnssec_ok == 1, "OPT header")
+assert(e.options == 4, "number of options")
+assert(e.have_ecs == 1 and e.have_cookie == 1 and e.have_ede == 1 and e.have_padding == 1, "options present")
+local codes = {}
+for opt in e:iterate(c.d) do
+    table.insert(codes, opt.code)
+    if opt.code == dns.EDNS0.OPT_CLIENT_SUBNET then
+        assert(opt.ecs_family == 1 and opt.ecs_scope_prefix == 0, "ECS family/scope")
+        assert(opt:ecs_subnet() == "192.0.2.0/24", "ECS subnet")
+    elseif opt.code == dns.EDNS0.OPT_COOKIE then
+        assert(opt.len == 8 and opt.data[0] == 1 and opt.data[7] == 8, "cookie")
+    elseif opt.code == dns.EDNS0.OPT_EDE then
+        assert(opt.ede_code == 18 and ffi.string(opt.data + 2, opt.len - 2) == "abcd", "EDE")
+    end
+end
+assert(table.concat(codes, ",") == "8,10,15,12", "option order")
+
+c = craft(header .. "\0\0\1\0\1")
+assert(c.d:parse_edns(e) == 0 and e.have_opt == 0, "no OPT record")
+
+c = craft("\0\1\1\0\0\1\0\0\0\0\0\1" .. "\0\0\1\0\1"
+    .. "\0\0\41\4\208\0\0\0\0\0\6\0\8\0\7\0\1")
+assert(c.d:parse_edns(e) ~= 0, "truncated option")
+
+payloads("dns.pcap-dist", function(obj, tcp)
+    d:reset()
+    d.obj_prev = obj
+    if tcp then
+        d.includes_dnslen = 1
+    end
+    if d:parse_msg(m) ~= 0 then
+        return
+    end
+    local have_opt = 0
+    for n = tonumber(m.rrs) - m.arcount, tonumber(m.rrs) - 1 do
+        if m.type[n] == dns.TYPE.OPT then
+            have_opt = 1
+            assert(d:parse_edns(e) == 0, "parse_edns failed")
+            assert(e.udp_size == m.class[n], "udp size differs")
+            break
+        end
+    end
+    assert(d:parse_edns(e) == 0 and e.have_opt == have_opt, "OPT presence differs")
+end)
+
+-----------------------------------------------------
+--   edit: patch header, strip/add OPT, qname suffix
+-----------------------------------------------------
+local ed = edit.new(512)
+local r = dns.new()
+local function reparse()
+    r:reset()
+    r.obj_prev = ed.payload:uncast()
+    return r:parse_msg(m)
+end
+
+-- query with an answer and an additional that point back into the question
+c = craft("\0\1\1\0\0\1\0\1\0\0\0\2" .. "\3www\7example\3com\0\0\1\0\1"
+    .. "\192\12\0\5\0\1\0\0\0\60\0\6\3foo\192\16"
+    .. "\0\0\41\16\0\0\0\0\0\0\0"
+    .. "\3bar\192\45\0\1\0\1\0\0\0\60\0\4\127\0\0\1")
+assert(ed:load(c.d) == 0, "load")
+assert(ed.payload.len == c.pl.len, "loaded length")
+assert(ed:id(0xbeef) == 0 and ed:rd(false) == 0, "id and rd")
+assert(reparse() == 0 and r.id == 0xbeef and r.rd == 0, "patched header")
+assert(ed:strip_edns() == 0, "strip_edns")
+assert(ed.payload.len == c.pl.len - 11, "stripped length")
+assert(reparse() == 0 and r.arcount == 1, "stripped arcount")
+assert(r:parse_edns(e) == 0 and e.have_opt == 0, "OPT still present")
+assert(m:name(r, 1) == "www.example.com." and m:name(r, 2) == "bar.foo.example.com.", "names after strip")
+assert(ed:add_edns(1232, true) == 0, "add_edns")
+assert(reparse() == 0 and r.arcount == 2, "added arcount")
+assert(r:parse_edns(e) == 0 and e.udp_size == 1232 and e.dnssec_ok == 1, "added OPT")
+assert(ed:add_edns(4096, false) == 0, "add_edns existing")
+assert(reparse() == 0 and r.arcount == 2, "arcount after update")
+assert(r:parse_edns(e) == 0 and e.udp_size == 4096 and e.dnssec_ok == 0, "updated OPT")
+assert(ed:qname_suffix("test") == 0, "qname_suffix")
+assert(reparse() == 0, "parse after suffix")
+assert(r:qname() == "www.example.com.test.", "suffixed qname")
+assert(m:name(r, 2) == "bar.foo.example.com.test.", "pointer after suffix")
+
+assert(ed:qname_suffix(string.rep("a", 64)) ~= 0, "label too long")
+c = craft(header .. string.rep("\63" .. string.rep("a", 63), 3) .. "\61" .. string.rep("a", 61) .. "\0\0\1\0\1")
+assert(ed:load(c.d) == 0 and ed:qname_suffix("a") ~= 0, "name too long")
+c = craft(header .. string.rep("\0", 500))
+assert(ed:load(c.d) ~= 0, "does not fit")
+
+payloads("dns.pcap-dist", function(obj, tcp)
+    d:reset()
+    d.obj_prev = obj
+    if tcp then
+        d.includes_dnslen = 1
+    end
+    if d:parse_msg(m) ~= 0 or m.qdcount == 0 or not m:name(d, 0) then
+        return
+    end
+    local qname, rrs = d:qname(), m.rrs
+    if ed:load(d) ~= 0 then
+        return
+    end
+    assert(ed:strip_edns() == 0 and reparse() == 0, "strip_edns on capture")
+    assert(r:qname() == qname, "qname after strip_edns")
+    assert(ed:qname_suffix("test") == 0 and reparse() == 0, "qname_suffix on capture")
+    assert(r:qname() == qname .. "test.", "qname after qname_suffix")
+    assert(m.rrs <= rrs, "records after edit")
+end)
@@ -308,3 +308,49 @@ while true do
         assert(ip_pkt(obj):destination() == "8.8.8.8")
     end
 end
+
+-----------------------------------------------------
+--        pellets.pcap: packet context
+--
+-- The packet context from the layer filter must
+-- match the object chain and ipsplit should find the
+-- ip6 layer through it.
+-----------------------------------------------------
+local input = require("dnsjit.input.pcap").new()
+local layer = require("dnsjit.filter.layer").new()
+local ipsplit = require("dnsjit.filter.ipsplit").new()
+local out1 = require("dnsjit.core.channel").new(256)
+local out2 = require("dnsjit.core.channel").new(256)
+
+input:open_offline("pellets.pcap-dist")
+layer:producer(input)
+layer:context(true)
+ipsplit:receiver(out1)
+ipsplit:receiver(out2)
+
+local prod, pctx = layer:produce()
+local recv, rctx = ipsplit:receive()
+
+while true do
+    local obj = prod(pctx)
+    if obj == nil then break end
+    assert(obj:type() == "packet", "top object is not a packet context")
+
+    local pkt = obj:cast()
+    assert(ffi.cast("void*", pkt.payload) == ffi.cast("void*", obj.obj_prev), "payload is not next in chain")
+    assert(pkt.ip_version == 6, "not IPv6")
+    assert(pkt:source() == ip_pkt(pkt.payload):source(), "source mismatch")
+    assert(pkt:destination() == ip_pkt(pkt.payload):destination(), "destination mismatch")
+    assert(pkt.proto == 17, "not UDP")
+    assert(pkt.sport == pkt.transport:cast().sport and pkt.dport == pkt.transport:cast().dport, "port mismatch")
+    assert(pkt.payload_offset > pkt.l4_offset and pkt.l4_offset > pkt.l3_offset, "bad offsets")
+    assert(pkt.ts.sec == pkt.pcap.ts.sec and pkt.ts.nsec == pkt.pcap.ts.nsec, "timestamp mismatch")
+
+    recv(rctx, obj)
+end
+out1:close()
+out2:close()
+
+assert(ipsplit:discarded() == 0, "some valid packets have been discarded")
+assert(out1:size() == 47, "out1: some IPv6 packets lost by filter")
+assert(out2:size() == 44, "out2: some IPv6 packets lost by filter")
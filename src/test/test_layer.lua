@@ -0,0 +1,239 @@
+-- Test cases for dnsjit.filter.layer
+local ffi = require("ffi")
+local object = require("dnsjit.core.objects")
+local channel = require("dnsjit.core.channel")
+local dns = require("dnsjit.core.object.dns").new()
+
+-- Return the payloads and their lower layer type, and the layer filter
+local function run(file, defrag, decap, ports, protos)
+    local input = require("dnsjit.input.fpcap").new()
+    local layer = require("dnsjit.filter.layer").new()
+    input:open(file)
+    layer:producer(input)
+    if defrag then
+        layer:defrag(defrag)
+    end
+    if decap then
+        layer:decap(true)
+    end
+    if ports then
+        layer:only(ports, protos)
+    end
+    local prod, pctx = layer:produce()
+    local pls = {}
+    while true do
+        local obj = prod(pctx)
+        if obj == nil then break end
+        if obj:type() == "payload" then
+            local pl = obj:cast()
+            local id
+            if obj.obj_prev:type() == "udp" then
+                dns.obj_prev = obj
+                if dns:parse_header() == 0 then
+                    id = dns.id
+                end
+            end
+            local chain = {}
+            local prev = obj.obj_prev
+            while prev ~= nil do
+                table.insert(chain, prev:type())
+                prev = prev.obj_prev
+            end
+            table.insert(pls, { len = tonumber(pl.len), prev = obj.obj_prev:type(), id = id, an = dns.ancount, chain = table.concat(chain, ",") })
+        end
+    end
+    return pls, layer
+end
+
+-----------------------------------------------------
+--   defrag: IPv4 fragment reassembly
+-----------------------------------------------------
+-- Fragments are passed through when not enabled
+local pls, layer = run("frags.pcap-dist")
+assert(#pls == 9, "all packets without defrag")
+local frags = 0
+for _, pl in pairs(pls) do
+    if pl.prev == "ip" then
+        frags = frags + 1
+    end
+end
+assert(frags == 7, "fragments without defrag")
+assert(layer:defrag_stats().fragments == 0, "stats without defrag")
+
+-- A response in three fragments received out of order, an incomplete
+-- datagram that expires, two overlapping fragments and a fragment that
+-- never completes
+for _, max in pairs({ 64, 1 }) do
+    pls, layer = run("frags.pcap-dist", max)
+    assert(#pls == 3, "payloads with defrag")
+    assert(pls[1].id == 1 and pls[3].id == 1, "unfragmented queries")
+    assert(pls[2].prev == "udp" and pls[2].len == 3233, "reassembled datagram")
+    assert(pls[2].id == 100 and pls[2].an == 200, "reassembled DNS")
+    local stats = layer:defrag_stats()
+    assert(stats.fragments == 7, "fragments")
+    assert(stats.reassembled == 1, "reassembled")
+    assert(stats.incomplete == 1, "incomplete")
+    assert(stats.overlapping == 1, "overlapping")
+    assert(stats.dropped == 0, "dropped")
+end
+
+-----------------------------------------------------
+--   defrag: IPv6 fragment reassembly
+-----------------------------------------------------
+pls, layer = run("frags6.pcap-dist")
+for _, pl in pairs(pls) do
+    assert(pl.prev == "ip6", "fragment parsed without defrag")
+end
+
+-- A response in three fragments received out of order, a fragment with
+-- the same lower 16 bits of identification, an atomic fragment, two
+-- overlapping fragments, a query with a destination options header in
+-- the fragmentable part and a fragment that expires the incomplete one
+pls, layer = run("frags6.pcap-dist", 64)
+assert(#pls == 3, "payloads with defrag")
+assert(pls[1].prev == "udp" and pls[1].len == 3233, "reassembled datagram")
+assert(pls[1].id == 100 and pls[1].an == 200, "reassembled DNS")
+assert(pls[2].prev == "udp" and pls[2].id == 3, "atomic fragment")
+assert(pls[3].prev == "udp" and pls[3].id == 4, "destination options in fragmentable part")
+local stats = layer:defrag_stats()
+assert(stats.fragments == 9, "fragments")
+assert(stats.reassembled == 2, "reassembled")
+assert(stats.incomplete == 1, "incomplete")
+assert(stats.overlapping == 1, "overlapping")
+assert(stats.dropped == 0, "dropped")
+
+-----------------------------------------------------
+--   decap: GRE, VXLAN, GENEVE and MPLS tunnels
+-----------------------------------------------------
+-- Only the plain query and the UDP tunnels give payloads when not enabled
+pls = run("tunnels.pcap-dist")
+assert(#pls == 4, "payloads without decap")
+assert(pls[4].id == 10, "plain query without decap")
+
+-- GRE with key and sequence, checksum and routing, VXLAN, GENEVE with an
+-- option, an MPLS label stack, an MPLS pseudowire with control word, MPLS
+-- over GRE, VXLAN in VXLAN and a plain query
+pls = run("tunnels.pcap-dist", nil, true)
+assert(#pls == 10, "payloads with decap")
+local chains = {
+    "udp,ip,gre,ip,ether,pcap",
+    "udp,ip6,gre,ip,ether,pcap",
+    "udp,ip,gre,ip,ether,pcap",
+    "udp,ip,ether,udp,ip,ether,pcap",
+    "udp,ip6,ether,udp,ip6,ether,pcap",
+    "udp,ip,ether,pcap",
+    "udp,ip,ether,ether,pcap",
+    "udp,ip,gre,ip,ether,pcap",
+}
+for n, chain in pairs(chains) do
+    assert(pls[n].id == n, "inner DNS " .. n)
+    assert(pls[n].chain == chain, "tunnel chain " .. n)
+end
+assert(pls[9].chain == "udp,ip,ether,udp,ip,ether,pcap" and pls[9].len == 79, "one level of tunnel")
+assert(pls[10].id == 10 and pls[10].chain == "udp,ip,ether,pcap", "plain query with decap")
+
+-----------------------------------------------------
+--   only: skip packets not allowed
+-----------------------------------------------------
+-- 82 DNS over UDP and 41 ICMP packets, the rest are not IP
+pls, layer = run("dns.pcap-dist", nil, nil, { 53 })
+assert(#pls == 82 and layer.obj.skipped == 51, "DNS only")
+pls, layer = run("dns.pcap-dist", nil, nil, { 5353 })
+assert(#pls == 0 and layer.obj.skipped == 133, "other port")
+pls, layer = run("dns.pcap-dist", nil, nil, {}, { "icmp" })
+assert(#pls == 0 and layer.obj.skipped == 92, "ICMP only")
+pls, layer = run("dns.pcap-dist", nil, nil, {}, { 17 })
+assert(#pls == 82 and layer.obj.skipped == 51, "any UDP port")
+
+-- Fragments are skipped unless reassembled
+pls, layer = run("frags.pcap-dist", nil, nil, { 53 })
+assert(#pls == 2 and layer.obj.skipped == 7, "fragments skipped")
+pls, layer = run("frags.pcap-dist", 64, nil, { 53 })
+assert(#pls == 3 and pls[2].len == 3233 and layer.obj.skipped == 0, "reassembled allowed")
+
+-- The inner packet of tunnels must be allowed
+pls, layer = run("tunnels.pcap-dist", nil, true, { 53 })
+assert(#pls == 9 and layer.obj.skipped == 1, "decapsulated allowed")
+for n = 1, 8 do
+    assert(pls[n].id == n, "decapsulated DNS " .. n)
+end
+pls, layer = run("tunnels.pcap-dist", nil, nil, { 53 })
+assert(#pls == 1 and layer.obj.skipped == 9, "tunnels skipped")
+
+-----------------------------------------------------
+--   Batches from inputs through layer
+-----------------------------------------------------
+for _, name in pairs({ "fpcap", "mmpcap" }) do
+    local counts = {}
+    for _, batched in pairs({ true, false }) do
+        local input = require("dnsjit.input." .. name).new()
+        local layer = require("dnsjit.filter.layer").new()
+        local chan = channel.new(256)
+        if batched then
+            input:batch(16)
+            layer:receiver(chan)
+            input:receiver(layer)
+        else
+            -- hide receive_batch() to get the per-object path
+            layer:receiver({ receive = function() return chan:receive() end })
+            input:receiver({ receive = function() return layer:receive() end })
+        end
+        assert(input:open("dns.pcap-dist") == 0, name .. ": open failed")
+        assert(input:run() == 0, name .. ": run failed")
+        local n = 0
+        while chan:try_get() ~= nil do
+            n = n + 1
+        end
+        table.insert(counts, n)
+    end
+    assert(counts[1] == 133 and counts[1] == counts[2], name .. ": batched and per-object differ")
+end
+
+-- A receiver without receive_batch() replaces the batch path
+local input = require("dnsjit.input.fpcap").new()
+local layer = require("dnsjit.filter.layer").new()
+local chan = channel.new(256)
+local plain = { receive = function() return chan:receive() end }
+input:batch(16)
+input:receiver(chan)
+layer:receiver(chan)
+assert(input.obj.recv_batch ~= nil and layer.obj.recv_batch ~= nil, "switch: batch receiver not set")
+input:receiver(plain)
+layer:receiver(plain)
+assert(input.obj.recv_batch == nil and layer.obj.recv_batch == nil, "switch: batch receiver not cleared")
+input:receiver(layer)
+assert(input:open("dns.pcap-dist") == 0, "switch: open failed")
+assert(input:run() == 0, "switch: run failed")
+local n = 0
+while chan:try_get() ~= nil do
+    n = n + 1
+end
+assert(n == 133, "switch: objects not delivered")
+
+-- The packet context of each lane has the offsets of its packet, all
+-- packets fit in one batch so the contexts are still valid after run()
+input = require("dnsjit.input.fpcap").new()
+layer = require("dnsjit.filter.layer").new()
+chan = channel.new(256)
+input:batch(256)
+layer:context(true)
+layer:receiver(chan)
+input:receiver(layer)
+assert(input:open("dns.pcap-dist") == 0, "context: open failed")
+assert(input:run() == 0, "context: run failed")
+local l3, l4 = 0, 0
+while true do
+    local obj = chan:try_get()
+    if obj == nil then
+        break
+    end
+    local pkt = ffi.cast("core_object_t*", obj):cast()
+    assert(pkt:type() == "packet", "context: not a packet context")
+    if pkt.l3_offset == 14 then
+        l3 = l3 + 1
+    end
+    if pkt.l4_offset == 34 then
+        l4 = l4 + 1
+    end
+end
+assert(l3 == 123 and l4 == 123, "context: offsets not set in batch")
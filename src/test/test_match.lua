@@ -0,0 +1,117 @@
+-- Test cases for dnsjit.filter.match
+local object = require("dnsjit.core.objects")
+
+-- Return the number of objects produced with the expression and the filter
+local function count(file, expression, context, decap)
+    local input = require("dnsjit.input.fpcap").new()
+    local layer = require("dnsjit.filter.layer").new()
+    local match = require("dnsjit.filter.match").new(expression)
+    input:open(file)
+    layer:producer(input)
+    layer:context(context)
+    layer:decap(decap)
+    match:producer(layer)
+    local prod, pctx = match:produce()
+    local n = 0
+    while prod(pctx) ~= nil do
+        n = n + 1
+    end
+    assert(match.obj.matched == n, "matched")
+    return n, match
+end
+
+-- 123 IPv4 packets of which 82 are DNS over UDP, 41 queries and 41
+-- responses, and 41 ICMP, between 172.17.0.10 and 8.8.8.8 or
+-- 216.58.218.206
+local tests = {
+    { "", 133 },
+    { "ip", 123 },
+    { "ip6", 0 },
+    { "udp", 82 },
+    { "not udp", 51 },
+    { "icmp", 41 },
+    { "proto 17", 82 },
+    { "port 53", 82 },
+    { "dst port 53", 41 },
+    { "src port 53 and response", 41 },
+    { "udp and port 1-52", 0 },
+    { "port 54-65535 and not port 53", 0 },
+    { "query", 41 },
+    { "response", 41 },
+    { "opcode QUERY", 82 },
+    { "opcode 5", 0 },
+    { "qtype A", 48 },
+    { "qtype 12", 34 },
+    { "qtype a or qtype PTR", 82 },
+    { "len > 50", 41 },
+    { "len <= 50", 41 },
+    { "len 0-65535", 82 },
+    { "len < 0", 0 },
+    { "icmp or len > 50", 82 },
+    { "src net 8.8.8.8,216.58.218.0/23", 58 },
+    { "dst host 172.17.0.8/30", 58 },
+    { "net 172.16.0.0/12", 123 },
+    { "net ::/0", 0 },
+    { "not (udp and query) and (icmp or response)", 82 },
+    { "udp and not (qtype A or src net 8.8.8.8)", 17 },
+    { "icmp and (query or response or opcode QUERY or qtype A)", 0 },
+}
+for _, test in pairs(tests) do
+    local expression, expect = test[1], test[2]
+    for _, context in pairs({ false, true }) do
+        local n, match = count("dns.pcap-dist", expression, context)
+        assert(match.obj.seen == 133, "seen")
+        assert(n == expect, "'" .. expression .. "' matched " .. n .. " expected " .. expect)
+    end
+end
+
+-- Invalid expressions raise an error and keep the current program
+local match = require("dnsjit.filter.match").new("udp")
+for _, expression in pairs({ "udp and", "(udp", "udp)", "port", "port 70000", "port 2-1",
+    "proto 256", "qtype NOPE", "net 10.0.0.0/33", "net 300.0.0.0", "foo", "len ~ 1" }) do
+    assert(not pcall(match.compile, match, expression), "'" .. expression .. "' is invalid")
+end
+local input = require("dnsjit.input.fpcap").new()
+local layer = require("dnsjit.filter.layer").new()
+input:open("dns.pcap-dist")
+layer:producer(input)
+local prod, pctx = layer:produce()
+local udp = 0
+while true do
+    local obj = prod(pctx)
+    if obj == nil then break end
+    if match:match(obj) then
+        udp = udp + 1
+    end
+end
+assert(udp == 82, "program kept after invalid expressions")
+
+-- The DNS tests only look at UDP and TCP payloads, not at a DNS query
+-- carried in an ICMP message
+local ffi = require("ffi")
+local query = "\0\1\1\0\0\1\0\0\0\0\0\0\3www\7example\3com\0\0\1\0\1"
+local buf = ffi.new("uint8_t[?]", #query)
+ffi.copy(buf, query, #query)
+local icmp = ffi.new("core_object_icmp_t")
+icmp.obj_type = object.ICMP
+local pl = ffi.new("core_object_payload_t")
+pl.obj_type = object.PAYLOAD
+pl.obj_prev = ffi.cast("core_object_t*", icmp)
+pl.payload = buf
+pl.len = #query
+for _, expression in pairs({ "query", "opcode QUERY", "qtype A" }) do
+    match:compile(expression)
+    assert(not match:match(ffi.cast("core_object_t*", pl)), "'" .. expression .. "' matched ICMP")
+end
+local udp = ffi.new("core_object_udp_t")
+udp.obj_type = object.UDP
+udp.dport = 53
+pl.obj_prev = ffi.cast("core_object_t*", udp)
+match:compile("query and qtype A")
+assert(match:match(ffi.cast("core_object_t*", pl)), "query over UDP not matched")
+
+-- Tests apply to the inner packet of tunnels
+assert(count("tunnels.pcap-dist", "udp and dst port 53", false, true) == 9, "decapsulated")
+assert(count("tunnels.pcap-dist", "udp and dst port 53", true, true) == 9, "decapsulated with context")
+assert(count("tunnels.pcap-dist", "ip6 and qtype A", false, true) == 2, "decapsulated IPv6")
+assert(count("tunnels.pcap-dist", "udp and dst port 53") == 1, "not decapsulated")
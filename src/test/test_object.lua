@@ -0,0 +1,31 @@
+-- Test cases for dnsjit.core.object
+local ffi = require("ffi")
+local object = require("dnsjit.core.object")
+require("dnsjit.core.object.payload")
+
+local pool = require("dnsjit.core.pool").new()
+local buf = ffi.new("uint8_t[?]", 100)
+local pl = ffi.new("core_object_payload_t")
+pl.obj_type = object.PAYLOAD
+
+-----------------------------------------------------
+--   Chain copy in one allocation
+-----------------------------------------------------
+require("dnsjit.core.object.pcap")
+local pkt = ffi.new("core_object_pcap_t")
+pkt.obj_type = object.PCAP
+pkt.bytes = buf
+pkt.caplen = 100
+pl.obj_prev = ffi.cast("core_object_t*", pkt)
+pl.payload = buf + 42
+pl.len = 58
+local copy = pl:uncast():copy_chain(pool)
+local cpl = copy:cast()
+local cpkt = copy:prev():cast()
+assert(cpl.obj_type == object.PAYLOAD and cpkt.obj_type == object.PCAP, "chain: bad chain")
+assert(cpkt.bytes ~= pkt.bytes and cpkt.caplen == 100, "chain: packet not copied")
+assert(cpl.payload == cpkt.bytes + 42, "chain: payload not within copied packet")
+copy:free()
+copy = pl:uncast():copy_chain(nil, object.PAYLOAD)
+assert(copy:prev() == nil and copy:cast().payload ~= pl.payload, "chain: type selection")
+copy:free()
@@ -0,0 +1,40 @@
+-- Test cases for dnsjit.core.pool
+local ffi = require("ffi")
+local channel = require("dnsjit.core.channel")
+local thread = require("dnsjit.core.thread")
+local object = require("dnsjit.core.object")
+require("dnsjit.core.object.payload")
+
+-----------------------------------------------------
+--   Pooled copies freed in another thread
+-----------------------------------------------------
+local pool = require("dnsjit.core.pool").new()
+local buf = ffi.new("uint8_t[?]", 100)
+local pl = ffi.new("core_object_payload_t")
+pl.obj_type = object.PAYLOAD
+pl.payload = buf
+pl.len = 100
+local chan = channel.new(64)
+local thr = thread.new()
+thr:start(function(thr)
+    local ffi = require("ffi")
+    require("dnsjit.core.object")
+    local chan = thr:pop()
+    while true do
+        local obj = chan:get()
+        if obj == nil then break end
+        ffi.cast("core_object_t*", obj):free()
+    end
+end)
+thr:push(chan)
+for n = 1, 1000 do
+    buf[0] = n % 256
+    local copy = pl:uncast():copy(pool):cast()
+    assert(copy.len == 100 and copy.payload[0] == n % 256, "pool: bad copy")
+    assert(copy.payload ~= pl.payload, "pool: payload not copied")
+    chan:put(copy)
+end
+chan:close()
+thr:stop()
+assert(tonumber(pool.allocs) == 1000, "pool: copies not from pool")
+assert(tonumber(pool.slabs_allocated) <= 4, "pool: freed copies not reused")
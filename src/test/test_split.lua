@@ -0,0 +1,53 @@
+-- Test cases for dnsjit.filter.split
+local ffi = require("ffi")
+local channel = require("dnsjit.core.channel")
+local thread = require("dnsjit.core.thread")
+local object = require("dnsjit.core.object")
+require("dnsjit.core.object.pcap")
+require("dnsjit.core.object.payload")
+
+local pool = require("dnsjit.core.pool").new()
+local buf = ffi.new("uint8_t[?]", 100)
+local pkt = ffi.new("core_object_pcap_t")
+pkt.obj_type = object.PCAP
+pkt.bytes = buf
+pkt.caplen = 100
+local pl = ffi.new("core_object_payload_t")
+pl.obj_type = object.PAYLOAD
+pl.obj_prev = ffi.cast("core_object_t*", pkt)
+pl.payload = buf + 42
+pl.len = 58
+
+-----------------------------------------------------
+--   Shared copies released by multiple threads
+-----------------------------------------------------
+local split = require("dnsjit.filter.split").new()
+local chans, consumers = {}, {}
+for t = 1, 2 do
+    chans[t] = channel.new(64)
+    consumers[t] = thread.new()
+    consumers[t]:start(function(thr)
+        local ffi = require("ffi")
+        require("dnsjit.core.object")
+        local chan = thr:pop()
+        while true do
+            local obj = chan:get()
+            if obj == nil then break end
+            ffi.cast("core_object_t*", obj):release()
+        end
+    end)
+    consumers[t]:push(chans[t])
+    split:receiver(chans[t])
+end
+split:sendall()
+split:retain(true)
+local recv, rctx = split:receive()
+local slabs = tonumber(pool.slabs_allocated)
+for n = 1, 1000 do
+    recv(rctx, pl:uncast():copy_chain(pool))
+end
+for t = 1, 2 do
+    chans[t]:close()
+    consumers[t]:stop()
+end
+assert(tonumber(pool.slabs_allocated) - slabs <= 4, "shared: copies not released")
@@ -0,0 +1,53 @@
+-- Test cases for dnsjit.filter.tcpdns
+local dns = require("dnsjit.core.object.dns").new()
+
+-----------------------------------------------------
+--   DNS messages from TCP streams
+-----------------------------------------------------
+local function tcpdns(file)
+    local input = require("dnsjit.input.fpcap").new()
+    local layer = require("dnsjit.filter.layer").new()
+    local filter = require("dnsjit.filter.tcpdns").new()
+    input:open(file)
+    layer:producer(input)
+    filter:producer(layer)
+    local prod, pctx = filter:produce()
+    local msgs = {}
+    while true do
+        local obj = prod(pctx)
+        if obj == nil then break end
+        if obj:type() == "payload" then
+            dns.obj_prev = obj
+            assert(dns:parse_header() == 0, "not a DNS message")
+            table.insert(msgs, { id = dns.id, prev = obj.obj_prev:type(), len = tonumber(obj:cast().len) })
+        end
+    end
+    return msgs, filter.obj
+end
+
+-- Two messages in one segment, a message in three segments received out
+-- of order and retransmitted, a message split in its length, a flow
+-- without SYN, a UDP message passed through, an incomplete message and a
+-- flow after the others have been idle
+local msgs, stats = tcpdns("tcpdns.pcap-dist")
+local ids = {}
+for _, m in pairs(msgs) do
+    table.insert(ids, m.id .. m.prev)
+end
+assert(table.concat(ids, ",") == "1tcp,2tcp,100tcp,3tcp,4tcp,5udp,6tcp", "messages")
+assert(msgs[3].len == 3233, "reordered message")
+assert(stats.segments == 14, "segments")
+assert(stats.messages == 6, "messages")
+assert(stats.flows == 5, "flows")
+assert(stats.evicted == 2, "evicted")
+assert(stats.dropped == 0, "dropped")
+
+-- Trailing junk after the response is not a complete message
+msgs, stats = tcpdns("tcp-response-with-trailing-junk.pcap-dist")
+local tcp = 0
+for _, m in pairs(msgs) do
+    if m.prev == "tcp" then
+        tcp = tcp + 1
+    end
+end
+assert(tcp == 2 and stats.messages == 2, "messages with trailing junk")
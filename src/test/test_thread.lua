@@ -0,0 +1,60 @@
+-- Test cases for dnsjit.core.thread
+local ffi = require("ffi")
+local channel = require("dnsjit.core.channel")
+local thread = require("dnsjit.core.thread")
+
+local function num(p)
+    return tonumber(ffi.cast("intptr_t", p))
+end
+
+-----------------------------------------------------
+--   Thread workers feeding a channel
+-----------------------------------------------------
+local chan = channel.new(16, channel.MPSC)
+local workers = thread.workers(3, function(thr)
+    local ffi = require("ffi")
+    local n, chan = thr:pop(2)
+    chan:put(ffi.cast("void*", n))
+end, { stack_size = 1024 * 1024 }, chan)
+assert(workers and #workers == 3, "workers: not started")
+local seen = {}
+for n = 1, 3 do
+    seen[num(chan:get())] = true
+end
+assert(seen[1] and seen[2] and seen[3], "workers: missing worker")
+for _, thr in pairs(workers) do
+    thr:stop()
+end
+
+-- The second worker can not be pinned, the first has run and is waited for
+chan = channel.new(16, channel.MPSC)
+workers = thread.workers(2, function(thr)
+    local ffi = require("ffi")
+    local n, chan = thr:pop(2)
+    chan:put(ffi.cast("void*", n))
+end, { cpus = { 0, -1 } }, chan)
+assert(workers == nil, "workers: started with an invalid cpu")
+assert(chan:size() <= 1, "workers: started after failure")
+
+-----------------------------------------------------
+--   Thread state factory
+-----------------------------------------------------
+local factory = thread.factory({ "dnsjit.core.channel", "dnsjit.filter.layer" })
+assert(factory, "factory: build failed")
+chan = channel.new(16, channel.MPSC)
+workers = thread.workers(2, function(thr)
+    local ffi = require("ffi")
+    local n, chan = thr:pop(2)
+    assert(package.loaded["dnsjit.filter.layer"], "factory: module not preloaded")
+    assert(package.preload["dnsjit.filter.layer"], "factory: module bytecode not preloaded")
+    chan:put(ffi.cast("void*", n))
+end, { factory = factory }, chan)
+assert(workers and #workers == 2, "factory: workers not started")
+seen = {}
+for n = 1, 2 do
+    seen[num(chan:get())] = true
+end
+assert(seen[1] and seen[2], "factory: missing worker")
+for _, thr in pairs(workers) do
+    thr:stop()
+end